@@ -125,8 +125,8 @@ void dataPopulate(DataCommunicate* comm, int count, int delay, int disp_row, int
     int i, j;
     for (i=0; i<comm->nprocs_x; i++) {//1
         for (j=0; j<comm->nprocs_y; j++) {//N
-            comm->counts[i*comm->nprocs_x+j] = count;
-            comm->displacements[i*comm->nprocs_x+j]=delay+i*disp_col+j*disp_row;//0 2 8 10
+            comm->counts[i*comm->nprocs_y+j] = count;
+            comm->displacements[i*comm->nprocs_y+j]=delay+i*disp_col+j*disp_row;//0 2 8 10
         }
     }
     /*printf("Counts:\t");
@@ -139,6 +139,63 @@ void dataPopulate(DataCommunicate* comm, int count, int delay, int disp_row, int
     }
     printf("\n");*/
 }
+/*
+ * Name: balancePartition
+ * Populates the counts and displacements arrays of the DataCommunicate structure with a balanced partition of N
+ * rows among its processes: the first N%procs get one row more than the others, so the slabs differ at most by a
+ * row (as the rows of createPlan), and every slab starts right after the one of the previous process.
+ *
+ * Input:
+ *      comm (DataCommunicate*) - Pointer to the DataCommunicate structure, with a count per process
+ *      N (int) - The number of rows partitioned
+ *      unit (int) - The elements of a row in counts and displacements (C for the floats of the slabs, 1 for rows)
+ *
+ * Output: none
+ */
+void balancePartition(DataCommunicate* comm, int N, int unit) {
+    const int procs=comm->nprocs_x*comm->nprocs_y;
+    int i;
+    for (i=0; i<procs; i++) {
+        comm->counts[i]=(N/procs+(i<N%procs ? 1 : 0))*unit;
+        comm->displacements[i]=(i*(N/procs)+MIN(i, N%procs))*unit;
+    }
+}
+/*
+ * Name: setupBatchCommunicators
+ * Creates the derived datatypes used to move a whole batch of N x N matrices with a single collective.
+ * The batch is stored as one contiguous (batch*N) x C matrix, so the slab of a process is made of
+ * batch strips of rows*C floats, one every N*C floats. On the way back every process owns batch*C rows
+ * of rows floats that have to be written one every N floats of the global transposed batch.
+ * Both types are resized so that displacement i in a Scatterv/Gatherv addresses the slab of process i.
+ *
+ * Input:
+ *      scatter (Communicator2D*) - Communicator receiving the type of a slab of the input batch
+ *      gather (Communicator2D*) - Communicator receiving the type of a slab of the transposed batch
+ *      batch (int) - Number of matrices in the batch
+ *      N (int) - Rows of each matrix of the batch
+ *      C (int) - Columns of each matrix of the batch
+ *      rows (int) - Number of rows of every matrix assigned to each process
+ *
+ * Output: none
+ */
+void setupBatchCommunicators(Communicator2D* scatter, Communicator2D* gather, int batch, int N, int C, int rows) {
+    scatter->sizes[0]=batch*N;
+    scatter->sizes[1]=C;
+    scatter->subsizes[0]=batch*rows;
+    scatter->subsizes[1]=C;
+    scatter->starts[0]=0;
+    scatter->starts[1]=0;
+    MPI_Type_vector(batch, rows*C, N*C, MPI_FLOAT, &scatter->submatrix_type);
+    MPI_Type_create_resized(scatter->submatrix_type, 0, rows*C*sizeof(float), &scatter->resized_type);
+    gather->sizes[0]=batch*C;
+    gather->sizes[1]=N;
+    gather->subsizes[0]=batch*C;
+    gather->subsizes[1]=rows;
+    gather->starts[0]=0;
+    gather->starts[1]=0;
+    MPI_Type_vector(batch*C, rows, N, MPI_FLOAT, &gather->submatrix_type);
+    MPI_Type_create_resized(gather->submatrix_type, 0, rows*sizeof(float), &gather->resized_type);
+}
 /*
  * Name: random_float2
  * Generates a random float number in a range with 2 decimals
@@ -310,26 +367,27 @@ bool checkSym (float** M, int size) {
 /*
  * Name: checkSymMPI
  * Verifies if a distributed square matrix is symmetric using MPI across multiple processes.
- * Each process checks a portion of the matrix and the results are reduced using MPI_Allreduce
- * to determine if the entire matrix is symmetric.
+ * Each process checks a portion of the rows of the matrix and the results are reduced using MPI_Allreduce
+ * to determine if the entire matrix is symmetric. A rectangular matrix (like the one of weak scaling) can't
+ * be symmetric, so in that case no check is done.
  *
  * Input:
  *      MGEN (float**) - The 2D matrix to be checked for symmetry (allocated in memory).
- *      N (int) - The dimension of the matrix (number of rows and columns, N x N).
+ *      N (int) - The number of rows of the matrix.
+ *      C (int) - The number of columns of the matrix.
  *      rank (int) - The rank of the current process in the MPI communicator.
- *      rows (int) - The number of rows of the matrix assigned to the current process.
- *      scaling (int) - A flag to indicate whether the check should be performed (scaling=0) or not (scaling!=0).
  *
  * Output:
  *      bool - Returns `true` if the matrix is symmetric across all processes, otherwise returns `false`.
  */
 
-bool checkSymMPI (float** MGEN, int N, int rank, int rows, int scaling) {
-    if(scaling==0) {
-        int num_procs=N/rows;
-        int rows_per_proc=(N+num_procs-1)/num_procs;
-        int start=rank*rows;
-        int end=MIN(start+rows_per_proc,N);
+bool checkSymMPI (float** MGEN, int N, int C, int rank) {
+    PHASE_BEGIN(PHASE_CHECK);
+    if(N==C) {
+        int num_procs;
+        MPI_Comm_size(actual_comm, &num_procs);
+        int start=(int)((long long)rank*N/num_procs);
+        int end=(int)((long long)(rank+1)*N/num_procs);
         //BOOLEAN SLOW
         int symmetric=1;
         int i, j;
@@ -345,27 +403,257 @@ bool checkSymMPI (float** MGEN, int N, int rank, int rows, int scaling) {
         //MPI_Reduce(&int_sim, &global_sim, 1, MPI_INT, MPI_MIN, 0, actual_comm);
         //MPI_Bcast(&global_sim, 1, MPI_INT, 0, actual_comm);
         MPI_Allreduce(&symmetric, &global, 1, MPI_INT, MPI_MIN, actual_comm);
+        PHASE_END(PHASE_CHECK);
         return (global==1);
     }
     else {
+        PHASE_END(PHASE_CHECK);
         return false;
     }
 }
+/*
+ * Name: checkSymMPIBatch
+ * Verifies the symmetry of every matrix of a batch. Each process checks its rows of all the matrices and
+ * the flags of the whole batch are reduced together with a single MPI_Allreduce, instead of one per matrix.
+ *
+ * Input:
+ *      MGEN (float**) - The batch of matrices stored as a (batch*N) x C matrix
+ *      N (int) - The number of rows of each matrix of the batch
+ *      C (int) - The number of columns of each matrix of the batch (a rectangular batch is never symmetric)
+ *      rank (int) - The rank of the current process in the MPI communicator
+ *      batch (int) - The number of matrices in the batch
+ *
+ * Output:
+ *      bool - Returns `true` if all the matrices of the batch are symmetric, otherwise returns `false`.
+ */
+bool checkSymMPIBatch (float** MGEN, int N, int C, int rank, int batch) {
+    if(N!=C) {
+        return false;
+    }
+    PHASE_BEGIN(PHASE_CHECK);
+    int* symmetric=malloc(sizeof(int)*batch);
+    int* global=malloc(sizeof(int)*batch);
+    if(symmetric==NULL || global==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    int b, i, j, num_procs;
+    MPI_Comm_size(actual_comm, &num_procs);
+    //The slice of rows of the process, as split by createPlan
+    const int start=sliceStart(N, num_procs, rank);
+    const int end=sliceStart(N, num_procs, rank+1);
+    for (b=0; b<batch; b++) {
+        float** A=&MGEN[b*N];
+        symmetric[b]=1;
+        for (i=start; i<end && (symmetric[b]==1); i++) {
+            for (j=0; j<i && (symmetric[b]==1); j++) {
+                if (ABS_DIFF(A[i][j], A[j][i])>ERROR) {
+                    symmetric[b]=0;
+                }
+            }
+        }
+    }
+    MPI_Allreduce(symmetric, global, batch, MPI_INT, MPI_MIN, actual_comm);
+    bool all=true;
+    for (b=0; b<batch; b++) {
+        if(global[b]==0) {
+            all=false;
+        }
+    }
+    free(symmetric);
+    free(global);
+    PHASE_END(PHASE_CHECK);
+    return all;
+}
+#if defined(__GNUC__)
+#define KERNEL_UNROLL _Pragma("GCC unroll 64")
+#define KERNEL_UNROLL_ROWS _Pragma("GCC unroll 8")
+#else
+#define KERNEL_UNROLL
+#define KERNEL_UNROLL_ROWS
+#endif
+//Tile of B x B elements with the bounds known at compile time, and the kernel of a matrix with the sides multiple of B
+//visited in these tiles. The unrolling is only asked to GCC: the row of the tile is unrolled, the rows by 8 (so the
+//tiles of 4 and 8 are unrolled completely), the other compilers just see the constant bounds
+#define DEFINE_TILE_KERNEL(B) \
+static inline void transposeTile##B(const float* restrict M, float* restrict T, int m_stride, int t_stride) { \
+    int i, j; \
+    KERNEL_UNROLL_ROWS \
+    for (i=0; i<(B); i++) { \
+        KERNEL_UNROLL \
+        for (j=0; j<(B); j++) { \
+            T[(size_t)j*t_stride+i]=M[(size_t)i*m_stride+j]; \
+        } \
+    } \
+} \
+static void transposeTiled##B(const float* restrict M, float* restrict T, int x, int y) { \
+    int ti, tj; \
+    for (ti=0; ti<x; ti+=(B)) { \
+        for (tj=0; tj<y; tj+=(B)) { \
+            transposeTile##B(&M[(size_t)ti*y+tj], &T[(size_t)tj*x+ti], y, x); \
+        } \
+    } \
+}
+//Square block of S x S elements in tiles of B x B, with also the bounds and the strides known at compile time
+#define DEFINE_BLOCK_KERNEL(S, B) \
+static void transposeBlock##S##Tile##B(const float* restrict M, float* restrict T, int x, int y) { \
+    int ti, tj; \
+    (void)x; \
+    (void)y; \
+    for (ti=0; ti<(S); ti+=(B)) { \
+        for (tj=0; tj<(S); tj+=(B)) { \
+            transposeTile##B(&M[ti*(S)+tj], &T[tj*(S)+ti], (S), (S)); \
+        } \
+    } \
+}
+#define DEFINE_BLOCK_KERNELS(S) DEFINE_BLOCK_KERNEL(S, 4) DEFINE_BLOCK_KERNEL(S, 8) DEFINE_BLOCK_KERNEL(S, 16) DEFINE_BLOCK_KERNEL(S, 32) DEFINE_BLOCK_KERNEL(S, 64)
+#define BLOCK_KERNELS(S) {transposeBlock##S##Tile4, transposeBlock##S##Tile8, transposeBlock##S##Tile16, transposeBlock##S##Tile32, transposeBlock##S##Tile64}
+DEFINE_TILE_KERNEL(4)
+DEFINE_TILE_KERNEL(8)
+DEFINE_TILE_KERNEL(16)
+DEFINE_TILE_KERNEL(32)
+DEFINE_TILE_KERNEL(64)
+//The tiles bigger than the block have no kernel
+DEFINE_BLOCK_KERNEL(16, 4)
+DEFINE_BLOCK_KERNEL(16, 8)
+DEFINE_BLOCK_KERNEL(16, 16)
+DEFINE_BLOCK_KERNEL(32, 4)
+DEFINE_BLOCK_KERNEL(32, 8)
+DEFINE_BLOCK_KERNEL(32, 16)
+DEFINE_BLOCK_KERNEL(32, 32)
+DEFINE_BLOCK_KERNELS(64)
+DEFINE_BLOCK_KERNELS(128)
+DEFINE_BLOCK_KERNELS(256)
+DEFINE_BLOCK_KERNELS(512)
+DEFINE_BLOCK_KERNELS(1024)
+DEFINE_BLOCK_KERNELS(2048)
+DEFINE_BLOCK_KERNELS(4096)
+//Dispatch tables, indexed by the logarithms of the side of the block and of the tile
+static const TransposeKernel tile_kernels[KERNEL_TILE_MAX_LOG-KERNEL_TILE_MIN_LOG+1]={transposeTiled4, transposeTiled8, transposeTiled16, transposeTiled32, transposeTiled64};
+static const TransposeKernel block_kernels[KERNEL_SIDE_MAX_LOG-KERNEL_SIDE_MIN_LOG+1][KERNEL_TILE_MAX_LOG-KERNEL_TILE_MIN_LOG+1]={
+    {transposeBlock16Tile4, transposeBlock16Tile8, transposeBlock16Tile16, NULL, NULL},
+    {transposeBlock32Tile4, transposeBlock32Tile8, transposeBlock32Tile16, transposeBlock32Tile32, NULL},
+    BLOCK_KERNELS(64),
+    BLOCK_KERNELS(128),
+    BLOCK_KERNELS(256),
+    BLOCK_KERNELS(512),
+    BLOCK_KERNELS(1024),
+    BLOCK_KERNELS(2048),
+    BLOCK_KERNELS(4096)
+};
+/*
+ * Name: selectKernel
+ * Picks from the dispatch tables the specialized kernel of the local transposition of a x x y matrix in tiles of
+ * tile x tile elements: the one of the square block when x and y are the same power of 2 (from 16 to 4096), the one
+ * of the tile when they are multiples of it, none with the tiles not a power of 2 from 4 to 64 or untiled.
+ * Input:
+ *      x (int) - Rows of the matrix
+ *      y (int) - Columns of the matrix
+ *      tile (int) - Side of the tiles (0 untiled)
+ * Output: TransposeKernel - The specialized kernel, NULL if the generic one has to be used
+ */
+TransposeKernel selectKernel(int x, int y, int tile) {
+    int t=0, s=0;
+    if(tile<=0 || (tile&(tile-1))!=0 || x%tile!=0 || y%tile!=0) {
+        return NULL;
+    }
+    while ((1<<t)<tile) {
+        t++;
+    }
+    if(t<KERNEL_TILE_MIN_LOG || t>KERNEL_TILE_MAX_LOG) {
+        return NULL;
+    }
+    if(x==y && (x&(x-1))==0) {
+        while ((1<<s)<x) {
+            s++;
+        }
+        if(s>=KERNEL_SIDE_MIN_LOG && s<=KERNEL_SIDE_MAX_LOG && block_kernels[s-KERNEL_SIDE_MIN_LOG][t-KERNEL_TILE_MIN_LOG]!=NULL) {
+            return block_kernels[s-KERNEL_SIDE_MIN_LOG][t-KERNEL_TILE_MIN_LOG];
+        }
+    }
+    return tile_kernels[t-KERNEL_TILE_MIN_LOG];
+}
+/*
+ * Name: describeKernel
+ * Writes which kernel transposes a x x y matrix in tiles of tile x tile elements (see selectKernel).
+ * Input:
+ *      x (int) - Rows of the matrix
+ *      y (int) - Columns of the matrix
+ *      tile (int) - Side of the tiles (0 untiled)
+ *      text (char*) - The description
+ *      size (size_t) - The size of text
+ * Output: none
+ */
+void describeKernel(int x, int y, int tile, char* text, size_t size) {
+    const TransposeKernel kernel=selectKernel(x, y, tile);
+    int t;
+    if(kernel==NULL) {
+        snprintf(text, size, "generic %dx%d (%s)", x, y, (tile>0) ? "tiled" : "untiled");
+        return;
+    }
+    for (t=0; t<=KERNEL_TILE_MAX_LOG-KERNEL_TILE_MIN_LOG; t++) {
+        if(kernel==tile_kernels[t]) {
+            snprintf(text, size, "specialized tile %d on %dx%d", tile, x, y);
+            return;
+        }
+    }
+    snprintf(text, size, "specialized block %dx%d tile %d", x, y, tile);
+}
+/*
+ * Name: defaultTile
+ * Tile of the local transposition of a x x y matrix when --tile isn't given: the biggest power of 2 up to
+ * DEFAULT_TILE dividing both the sides, so the shapes powers of 2 run a specialized kernel of selectKernel.
+ * Input:
+ *      x (int) - Rows of the matrix
+ *      y (int) - Columns of the matrix
+ * Output: int - The side of the tile, 0 (untiled) when not even the smallest tile of the kernels divides the sides
+ */
+int defaultTile(int x, int y) {
+    int tile=DEFAULT_TILE;
+    while (tile>=(1<<KERNEL_TILE_MIN_LOG) && (x%tile!=0 || y%tile!=0)) {
+        tile/=2;
+    }
+    return (tile>=(1<<KERNEL_TILE_MIN_LOG)) ? tile : 0;
+}
 /*
  * Name: matTranspose
  * Does a standard transposition. Even if the one with a temporal variable is more
  * efficient considering the cycle will be on half of that matrix, this is a more
  * general one, which allows us to use more elements to optimize this code.
+ * The kernel picked once by createPlan (see selectKernel) transposes the contiguous storage without the pointers
+ * of the rows. Without it, with options.tile>0 the matrix is visited in tiles of tile x tile elements, so the
+ * columns of T written by a tile stay in cache until the tile is completed.
  * Input:
  *      M (float**) - The allocated in heap matrix
  *      size (int) - Dimension of the side of the squared matrix
+ *      kernel (TransposeKernel) - Specialized kernel of the x x y shape, NULL for the generic loops
  * Output: float** - Resulting matrix, after transposition
  */
-void matTranspose (float** M, float** T, int x, int y) {
+void matTranspose (float** M, float** T, int x, int y, TransposeKernel kernel) {
     int i, j;
-    for (i=0; i<x; i++) {
-        for (j=0; j<y; j++) {
-            T[j][i]=M[i][j];
+    //Only the matrices of create2DFloatMatrix, with the rows one after the other
+    if(kernel!=NULL && M[x-1]==M[0]+(size_t)(x-1)*y && T[y-1]==T[0]+(size_t)(y-1)*x) {
+        kernel(M[0], T[0], x, y);
+        return;
+    }
+    if(options.tile<=0) {
+        for (i=0; i<x; i++) {
+            for (j=0; j<y; j++) {
+                T[j][i]=M[i][j];
+            }
+        }
+        return;
+    }
+    const int B=options.tile;
+    int ti, tj;
+    for (ti=0; ti<x; ti+=B) {
+        for (tj=0; tj<y; tj+=B) {
+            for (i=ti; i<MIN(ti+B, x); i++) {
+                for (j=tj; j<MIN(tj+B, y); j++) {
+                    T[j][i]=M[i][j];
+                }
+            }
         }
     }
 }
@@ -374,6 +662,9 @@ void matTranspose (float** M, float** T, int x, int y) {
  * Performs a matrix transpose operation in a distributed setting using MPI, where the original matrix is divided
  * across multiple processes. After transposing the local portion of the matrix, it gathers the transposed data from
  * all processes and combines them into a global matrix.
+ * The slabs are the balanced partition of createPlan (balancePartition), so the processes don't have to divide N:
+ * the scatter moves floats with the count of each slab, and every row of the transposed matrix is gathered with
+ * the pieces of the processes of different lengths one after the other.
  *
  * Input:
  *      MGEN (float**) - The original matrix (before transpose), distributed across processes.
@@ -381,322 +672,2904 @@ void matTranspose (float** M, float** T, int x, int y) {
  *      T (float**) - The local transposed portion of the matrix.
  *      TGEN (float**) - The globally transposed matrix (after all processes perform transpose).
  *      rank (int) - The rank of the current MPI process.
- *      N (int) - The size of the matrix (N x N), a square matrix.
+ *      N (int) - The number of rows of the matrix (N x C), in weak scaling the rows of all the processes.
+ *      C (int) - The number of columns of the matrix.
  *      rows (int) - The number of rows assigned to the current process.
- *      scaling (int) - A flag indicating whether the matrix transpose operation should be scaled.
- *      sending (DataCommunicate) - Contains information about the communication size and displacements for sending data.
- *      receiving (DataCommunicate) - Contains information about the communication size and displacements for receiving data.
- *      sender (Communicator2D) - The MPI communicator object containing details about the matrix distribution.
+ *      sending (DataCommunicate) - Floats of the slab of each process and their offsets in the matrix.
+ *      receiving (DataCommunicate) - Rows of the slab of each process and their offsets in a row of the transposed matrix.
  *
  * Output: none
  */
 
-void matTransposeMPIAllGather (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int rows, int scaling, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender) {
-    int i, j;
-    MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, sender.resized_type, localrecvptr, rows*N, MPI_FLOAT, 0, actual_comm);
-    //matrixCheckPerRank(M, rank, rows, N);
+void matTransposeMPIAllGather (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int C, int rows, DataCommunicate sending, DataCommunicate receiving, TransposeKernel kernel) {
+    int i;
+    PHASE_BEGIN(PHASE_SCATTER);
+    MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, MPI_FLOAT, localrecvptr, rows*C, MPI_FLOAT, 0, actual_comm);
+    PHASE_END(PHASE_SCATTER);
+    //matrixCheckPerRank(M, rank, rows, C);
     //printf("======RANK %d ======\n", rank);
-    //printMatrix(M, rows, N);
-    matTranspose(M, T, rows, N);
-    //printMatrix(T, N, rows);
-    if(scaling==1){
-        for (i=0; i<N; i++) {
-            dataPopulate(&receiving, rows, i*N*sending.nprocs_y, rows, 1);
-            localsendptr=&(T[i][0]);
-            MPI_Gatherv(localsendptr, rows, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
-        }
-    }
-    else {
-        if(scaling==0) {
-            for (i=0; i<N; i++) {
-                dataPopulate(&receiving, rows, i*N, rows, 1);
-                localsendptr=&(T[i][0]);
-                MPI_Gatherv(localsendptr, rows, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
-            }
-        }
+    //printMatrix(M, rows, C);
+    PHASE_BEGIN(PHASE_TRANSPOSE);
+    matTranspose(M, T, rows, C, kernel);
+    PHASE_END(PHASE_TRANSPOSE);
+    //printMatrix(T, C, rows);
+    PHASE_BEGIN(PHASE_GATHER);
+    //Row i of the transposed matrix (C x N) starts at i*N, the piece of each process is after the rows of the previous ones
+    for (i=0; i<C; i++) {
+        localsendptr=&(T[i][0]);
+        MPI_Gatherv(localsendptr, rows, MPI_FLOAT, (rank==0) ? globalrecvptr+(size_t)i*N : NULL, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
     }
+    PHASE_END(PHASE_GATHER);
 }
 /*
  * Name: matTransposeMPIBlock
  * Performs a block-wise matrix transpose operation in a distributed setting using MPI, where the matrix is divided
  * into blocks distributed across multiple processes. Each process handles a block of the matrix and exchanges
- * data with other processes to ensure the correct transpose operation.
+ * data with other processes to ensure the correct transpose operation. The process in position (i, j) of the
+ * grid sends its block to the owner of the position (j, i) of the transposed grid and receives the block it owns
+ * from the process stored in the global transposer (with a square grid they are the same process).
  *
  * Input:
  *      MGEN (float**) - The original matrix (before transpose), distributed across processes.
- *      M (float**) - The local portion of the matrix assigned to the current process for transpose.
- *      T (float**) - The local transposed portion of the matrix.
+ *      M (float**) - The local portion of the matrix assigned to the current process for transpose (rows x cols).
+ *      T (float**) - The local transposed portion of the matrix (cols x rows).
  *      TGEN (float**) - The globally transposed matrix (after all processes perform transpose).
  *      rank (int) - The rank of the current MPI process.
- *      N (int) - The size of the matrix (N x N), a square matrix.
- *      rows (int) - The number of rows assigned to the current process.
+ *      N (int) - The number of rows of the matrix (N x C).
+ *      C (int) - The number of columns of the matrix.
+ *      rows (int) - The number of rows of the block assigned to the current process.
+ *      cols (int) - The number of columns of the block assigned to the current process.
  *      sending (DataCommunicate) - Contains information about the communication size and displacements for sending data.
  *      receiving (DataCommunicate) - Contains information about the communication size and displacements for receiving data.
  *
  * Output: none
  */
 
-void matTransposeMPIBlock (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int rows, DataCommunicate sending, DataCommunicate receiving) {
+void matTransposeMPIBlock (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, TransposeKernel kernel) {
     int i, j;
+    PHASE_BEGIN(PHASE_SCATTER);
     for (i=0; i<rows; i++) {
-        dataPopulate(&sending, rows, i*N, rows, rows*N);
+        dataPopulate(&sending, cols, i*C, cols, rows*C);
         localrecvptr=&(M[i][0]);
         //MPI_Barrier(actual_comm);
-        MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, MPI_FLOAT, localrecvptr, rows, MPI_FLOAT, 0, actual_comm);
+        MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, MPI_FLOAT, localrecvptr, cols, MPI_FLOAT, 0, actual_comm);
     }
-    //matrixCheckPerRank(M, rank, rows, N);
-    //printMatrix(M, rows, rows);
-    int col=rank%(N/rows);
-    int row=rank/(N/rows);
-    //printf("Rank %d (%d %d)", rank, row, col);
-    //MPI_Barrier(actual_comm);
-    //printf("Rank %d (%d %d)\n", rank, row, col);
-    if(row!=col) {//5 [1][2] -> 7 [2][1]
-        int rank_dest=col*(N/rows)+row;
-        int tag;
-        MPI_Status status;
-        //No deadlock logic
-        if(row<col) {
-            tag=rank*sending.nprocs_x*sending.nprocs_y + rank_dest;
-            for (i = 0; i < rows; i++) {
-                for (j = 0; j < rows; j++) {
-                    MPI_Send(&M[i][j], 1, MPI_FLOAT, rank_dest, tag, actual_comm);
-                    //printf("Send value %.2f", M[i][j]);
-                }
-            }
-            for (i = 0; i < rows; i++) {
-                for (j = 0; j < rows; j++) {
-                    MPI_Recv(&T[j][i], 1, MPI_FLOAT, rank_dest, tag, actual_comm, &status);
-                    //printf("Received value %.2f", T[j][i]);
-                }
-            }
-        }
-        else {
-            tag=rank_dest*sending.nprocs_x*sending.nprocs_y + rank;
-            for (i = 0; i < rows; i++) {
-                for (j = 0; j < rows; j++) {
-                    MPI_Recv(&T[j][i], 1, MPI_FLOAT, rank_dest, tag, actual_comm, &status);
-                    //printf("Received value %.2f", T[j][i]);
-                }
-            }
-            for (i = 0; i < rows; i++) {
-                for (j = 0; j < rows; j++) {
-                    MPI_Send(&M[i][j], 1, MPI_FLOAT, rank_dest, tag, actual_comm);
-                    //printf("Send value %.2f", M[i][j]);
-                }
+    PHASE_END(PHASE_SCATTER);
+    //matrixCheckPerRank(M, rank, rows, cols);
+    //printMatrix(M, rows, cols);
+    //printf("Rank %d (%d %d)\n", rank, transposer.coords_start[0], transposer.coords_start[1]);
+    if(transposer.rank_dest!=transposer.rank_start) {//5 [1][2] -> 7 [2][1]
+        //No deadlock logic, each element is sent to the destination while the one in the same position is received from the source
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        for (i = 0; i < rows; i++) {
+            for (j = 0; j < cols; j++) {
+                MPI_Sendrecv(&M[i][j], 1, MPI_FLOAT, transposer.rank_dest, 0, &T[j][i], 1, MPI_FLOAT, transposer.rank_src, 0, actual_comm, MPI_STATUS_IGNORE);
+                //printf("Send value %.2f Received value %.2f", M[i][j], T[j][i]);
             }
         }
+        PHASE_END(PHASE_EXCHANGE);
     }
     else {
-        matTranspose(M, T, rows, rows);
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        matTranspose(M, T, rows, cols, kernel);
+        PHASE_END(PHASE_TRANSPOSE);
     }
     //printf("======RANK %d ======\n", rank);
-    //printMatrix(T, rows, rows);
+    //printMatrix(T, cols, rows);
     //MPI_Barrier(actual_comm);
-    for (i=0; i<rows; i++) {
+    PHASE_BEGIN(PHASE_GATHER);
+    for (i=0; i<cols; i++) {
         if(rank==0){
-            dataPopulate(&receiving, rows, i*N, rows, rows*N);
+            dataPopulate(&receiving, rows, i*N, rows, cols*N);
         }
         localsendptr=&(T[i][0]);
         MPI_Gatherv(localsendptr, rows, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
     }
+    PHASE_END(PHASE_GATHER);
     //MPI_Barrier(actual_comm);
 }
+/*
+ * Name: packTransposed
+ * Packs the contiguous x x y block M in buf already transposed (buf[j*x+i]=M[i*y+j]), so the exchanged block
+ * is received directly as the transposed one. The block is visited in tiles of PACK_TILE x PACK_TILE elements
+ * and inside a tile the 4 x 4 sub-blocks are transposed in the registers with SSE (4 rows of M loaded,
+ * _MM_TRANSPOSE4_PS, 4 rows of buf stored); the edges not multiple of 4 and the processors without SSE go
+ * element by element.
+ * Input:
+ *      M (const float*) - The block to pack
+ *      buf (float*) - The y x x send buffer
+ *      x (int) - Rows of the block
+ *      y (int) - Columns of the block
+ * Output: none
+ */
+void packTransposed(const float* restrict M, float* restrict buf, int x, int y) {
+    int ti, tj, i, j;
+    for (ti=0; ti<x; ti+=PACK_TILE) {
+        const int i_end=MIN(ti+PACK_TILE, x);
+        for (tj=0; tj<y; tj+=PACK_TILE) {
+            const int j_end=MIN(tj+PACK_TILE, y);
+            i=ti;
+#if defined(__SSE__)
+            for (; i+4<=i_end; i+=4) {
+                const float* m=&M[(size_t)i*y];
+                for (j=tj; j+4<=j_end; j+=4) {
+                    __m128 r0=_mm_loadu_ps(&m[j]);
+                    __m128 r1=_mm_loadu_ps(&m[(size_t)y+j]);
+                    __m128 r2=_mm_loadu_ps(&m[2*(size_t)y+j]);
+                    __m128 r3=_mm_loadu_ps(&m[3*(size_t)y+j]);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    _mm_storeu_ps(&buf[(size_t)j*x+i], r0);
+                    _mm_storeu_ps(&buf[(size_t)(j+1)*x+i], r1);
+                    _mm_storeu_ps(&buf[(size_t)(j+2)*x+i], r2);
+                    _mm_storeu_ps(&buf[(size_t)(j+3)*x+i], r3);
+                }
+                for (; j<j_end; j++) {
+                    buf[(size_t)j*x+i]=m[j];
+                    buf[(size_t)j*x+i+1]=m[(size_t)y+j];
+                    buf[(size_t)j*x+i+2]=m[2*(size_t)y+j];
+                    buf[(size_t)j*x+i+3]=m[3*(size_t)y+j];
+                }
+            }
+#endif
+            for (; i<i_end; i++) {
+                for (j=tj; j<j_end; j++) {
+                    buf[(size_t)j*x+i]=M[(size_t)i*y+j];
+                }
+            }
+        }
+    }
+}
 /*
  * Name: matTransposeMPIBlockOPT
  * Performs an optimized block-wise matrix transpose operation in a distributed setting using MPI. Each process
  * handles a local block of the matrix and exchanges the data with other processes to ensure the correct transpose
  * operation. This version improves upon the previous version by using `MPI_Sendrecv` for communication, which
- * optimizes the data exchange by combining send and receive operations into a single call.
+ * optimizes the data exchange by combining send and receive operations into a single call (see exchangeFloats,
+ * that may compress the block on the wire).
+ * The block is transposed on the way out, so it's received directly in T without a second pass: with
+ * --pack=manual (default) packTransposed writes it in tempM, with --pack=datatype it's sent by columns with the
+ * derived datatype of the plan and the MPI library does the packing inside the exchange (never compressed).
  *
  * Input:
  *      MGEN (float**) - The original matrix (before transpose), distributed across processes.
  *      M (float**) - The local portion of the matrix assigned to the current process for transpose.
  *      T (float**) - The local transposed portion of the matrix.
  *      TGEN (float**) - The globally transposed matrix (after all processes perform transpose).
- *      tempM (float**) - Temporary matrix used for communication between processes.
+ *      tempM (float**) - Send buffer of the block packed transposed (cols x rows).
  *      rank (int) - The rank of the current MPI process.
- *      N (int) - The size of the matrix (N x N), a square matrix.
- *      rows (int) - The number of rows assigned to the current process.
+ *      N (int) - The number of rows of the matrix (N x C).
+ *      C (int) - The number of columns of the matrix.
+ *      rows (int) - The number of rows of the block assigned to the current process.
+ *      cols (int) - The number of columns of the block assigned to the current process.
  *      sending (DataCommunicate) - Contains information about the communication size and displacements for sending data.
  *      receiving (DataCommunicate) - Contains information about the communication size and displacements for receiving data.
+ *      column (MPI_Datatype) - A column of the block, resized to a float (created by createPlan with --pack=datatype).
  *
  * Output: none
  */
 
-void matTransposeMPIBlockOPT (float** MGEN, float** M, float** T, float** TGEN, float** tempM, int rank, int N, int rows, DataCommunicate sending, DataCommunicate receiving) {
+void matTransposeMPIBlockOPT (float** MGEN, float** M, float** T, float** TGEN, float** tempM, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, MPI_Datatype column) {
     int i, j, target_rank;
     double time_s, time_e;
     //if(rank==0) {
     //    printMatrix(MGEN, N, N);
     //}
+    PHASE_BEGIN(PHASE_SCATTER);
     for (i = 0; i < rows; i++) {
-        dataPopulate(&sending, rows, i*N, rows, rows*N);
+        dataPopulate(&sending, cols, i*C, cols, rows*C);
         localrecvptr = &(M[i][0]);
         MPI_Barrier(actual_comm);
-        MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, MPI_FLOAT, localrecvptr, rows, MPI_FLOAT, 0, actual_comm);
+        MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, MPI_FLOAT, localrecvptr, cols, MPI_FLOAT, 0, actual_comm);
     }
+    PHASE_END(PHASE_SCATTER);
     //printf("===== M - RANK %d ====\n", rank);
     //printMatrix(M, rows, rows);
     //MPI_Barrier(actual_comm);
     localrecvptr=&(M[0][0]);
     float* tempptr=&(tempM[0][0]);
-    MPI_Sendrecv(localrecvptr, rows*rows, MPI_FLOAT, transposer.rank_dest, 0,
-                 tempptr, rows*rows, MPI_FLOAT, transposer.rank_dest, 0,
-                     actual_comm, MPI_STATUS_IGNORE);
-    //printf("===== tempM - RANK %d ====\n", rank);
-    //printMatrix(tempM, rows, rows);
-    //MPI_Barrier(actual_comm);
-    matTranspose(tempM, T, rows, rows);
+    if(column!=MPI_DATATYPE_NULL) {
+        //The packing by the datatype happens inside MPI_Sendrecv, so it's counted in the exchange
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        MPI_Sendrecv(localrecvptr, cols, column, transposer.rank_dest, 0, &(T[0][0]), rows*cols, MPI_FLOAT, transposer.rank_src, 0, actual_comm, MPI_STATUS_IGNORE);
+        PHASE_END(PHASE_EXCHANGE);
+    }
+    else {
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        packTransposed(localrecvptr, tempptr, rows, cols);
+        PHASE_END(PHASE_TRANSPOSE);
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        exchangeFloats(tempptr, transposer.rank_dest, &(T[0][0]), transposer.rank_src, rows*cols, 0);
+        PHASE_END(PHASE_EXCHANGE);
+    }
     //printf("===== T - RANK %d ====\n", rank);
-    //printMatrix(T, rows, rows);
+    //printMatrix(T, cols, rows);
     //MPI_Barrier(actual_comm);
-    for (i = 0; i < rows; i++) {
+    PHASE_BEGIN(PHASE_GATHER);
+    for (i = 0; i < cols; i++) {
         if(rank==0){
-            dataPopulate(&receiving, rows, i*N, rows, rows*N);
+            dataPopulate(&receiving, rows, i*N, rows, cols*N);
         }
         localsendptr = &(T[i][0]);
         MPI_Gatherv(localsendptr, rows, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
     }
+    PHASE_END(PHASE_GATHER);
     //if(rank==0) {
     //    printMatrix(TGEN, N, N);
     //}
 }
 
 /*
- * Name: PrintMatrix
- * Prints out on stdout all the Matrix indexed. This was used for control to verify that the program worked for small matrices. It's not present in the running code
- *   Input:
- *      M (float**) - The start allocated in heap matrix
- *      size(int) - Dimension of the matrix
+ * Name: matTransposeMPIBatch
+ * Transposes a batch of independent N x N matrices in a single execution. The slabs of rows of all the
+ * matrices assigned to a process travel in one MPI_Scatterv, the local transposition is dispatched over
+ * the whole batch and the transposed slabs come back to rank 0 in one MPI_Gatherv, so the latency of the
+ * collectives is paid once per batch and not once per matrix (or per row).
+ *
+ * Input:
+ *      M (float**) - The local slabs, batch*rows rows of C floats (matrix b starts at row b*rows)
+ *      T (float**) - The local transposed slabs, batch*C rows of rows floats (matrix b starts at row b*C)
+ *      C (int) - The number of columns of each matrix of the batch
+ *      rows (int) - The number of rows of each matrix assigned to the current process
+ *      batch (int) - The number of matrices in the batch
+ *      sending (DataCommunicate) - Counts (1) and displacements (rank) of the slab of each process
+ *      scatter (Communicator2D) - Type of a slab of the input batch (see setupBatchCommunicators)
+ *      gather (Communicator2D) - Type of a slab of the transposed batch (see setupBatchCommunicators)
+ *
  * Output: none
  */
-void printMatrix(float** M, int x, int y) {
-    int i, j;
-    for (i=0; i<x; i++) {
-        for(j=0; j<y; j++) {
-            printf("%.2f\t", M[i][j]);
-        }
-        printf("\n");
+void matTransposeMPIBatch (float** M, float** T, int C, int rows, int batch, DataCommunicate sending, Communicator2D scatter, Communicator2D gather, TransposeKernel kernel) {
+    int b;
+    PHASE_BEGIN(PHASE_SCATTER);
+    MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, scatter.resized_type, &(M[0][0]), batch*rows*C, MPI_FLOAT, 0, actual_comm);
+    PHASE_END(PHASE_SCATTER);
+    PHASE_BEGIN(PHASE_TRANSPOSE);
+    for (b=0; b<batch; b++) {
+        matTranspose(&M[b*rows], &T[b*C], rows, C, kernel);
     }
+    PHASE_END(PHASE_TRANSPOSE);
+    PHASE_BEGIN(PHASE_GATHER);
+    MPI_Gatherv(&(T[0][0]), batch*C*rows, MPI_FLOAT, globalrecvptr, sending.counts, sending.displacements, gather.resized_type, 0, actual_comm);
+    PHASE_END(PHASE_GATHER);
 }
+
 /*
- * Name: matrixCheckPerRank
- * Prints the matrix data that has been assigned to the current MPI rank for debugging purposes.
- * This function is useful to verify the data distribution across processes.
+ * Name: setupHierarchy
+ * Prepares the communicators and the shared memory of the hierarchical transposition. The processes are grouped
+ * by node with MPI_Comm_split_type (or in nodes of options.node_size consecutive ranks, to emulate more nodes on
+ * a single one) and the first process of each node joins the communicator of the leaders. Every process exposes
+ * in two windows allocated with MPI_Win_allocate_shared its slab of the start matrix and of the transposed one,
+ * so the leader can read and write the slabs of the whole node without messages.
  *
  * Input:
- *      M (float**) - The matrix to be printed. This is the local portion of the matrix assigned to the current rank.
- *      rank (int) - The rank of the current MPI process.
- *      x (int) - The number of rows assigned to the current process.
- *      y (int) - The number of columns assigned to the current process.
+ *      h (Hierarchy*) - The structure to initialize
+ *      input_count (int) - Floats of the slab of the start matrix of each process
+ *      output_count (int) - Floats of the slab of the transposed matrix of each process
  *
  * Output: none
  */
-
-void matrixCheckPerRank(float** M, int rank, int x, int y) {
-    int i, j;
-    printf("Rank %d scatter\n\n", rank);
-    for (i=0; i<x; i++) {
-        for (j=0; j<y; j++) {
-            printf("Rank: %d %d %d - %.2f\n", rank, i+1, j+1, M[i*x+j]);
+void setupHierarchy(Hierarchy* h, int input_count, int output_count) {
+    int rank, num_procs, i;
+    MPI_Comm_rank(actual_comm, &rank);
+    MPI_Comm_size(actual_comm, &num_procs);
+    if(options.node_size>0) {
+        MPI_Comm_split(actual_comm, rank/options.node_size, rank, &h->node_comm);
+    }
+    else {
+        MPI_Comm_split_type(actual_comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &h->node_comm);
+    }
+    MPI_Comm_rank(h->node_comm, &h->node_rank);
+    MPI_Comm_size(h->node_comm, &h->node_size);
+    MPI_Comm_split(actual_comm, (h->node_rank==0) ? 0 : MPI_UNDEFINED, rank, &h->leader_comm);
+    int node=0;
+    if(h->leader_comm!=MPI_COMM_NULL) {
+        MPI_Comm_rank(h->leader_comm, &node);
+        MPI_Comm_size(h->leader_comm, &h->nodes);
+    }
+    MPI_Bcast(&node, 1, MPI_INT, 0, h->node_comm);
+    MPI_Bcast(&h->nodes, 1, MPI_INT, 0, h->node_comm);
+    h->node_of=malloc(sizeof(int)*num_procs);
+    if(h->node_of==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    MPI_Allgather(&node, 1, MPI_INT, h->node_of, 1, MPI_INT, actual_comm);
+    MPI_Win_allocate_shared((MPI_Aint)input_count*sizeof(float), sizeof(float), MPI_INFO_NULL, h->node_comm, &h->input, &h->input_win);
+    MPI_Win_allocate_shared((MPI_Aint)output_count*sizeof(float), sizeof(float), MPI_INFO_NULL, h->node_comm, &h->output, &h->output_win);
+    if(rank==0) {
+        printf("Hierarchical transposition on %d nodes: %d messages among nodes instead of %d among processes\n", h->nodes, h->nodes*(h->nodes-1), num_procs*(num_procs-1));
+        for (i=0; i<num_procs; i++) {
+            printf("Rank %d -> Node %d\n", i, h->node_of[i]);
         }
-        printf("\n");
     }
 }
 /*
- * Name: control
- * Another control algorithm for verifying that the transposition happened correctly. Happened a transposition of
- *   Input:
- *      M (float**) - The start allocated in heap matrix
- *      T (float**) - The destination allocated in heap matrix
- *      size(int) - Dimension of the matrix
+ * Name: freeHierarchy
+ * Frees the windows, the communicators and the map of the nodes created by setupHierarchy.
+ *
+ * Input:
+ *      h (Hierarchy*) - The structure to free
+ *
  * Output: none
  */
-void control(float** M, float** T, int N) {
-    printf("[%d][%d] M: %.2f T: %.2f\n", 1, 2, M[1][2], T[2][1]);
-    printf("[%d][%d] M: %.2f T: %.2f\n", N/2-4, N/2+2, M[N/2-4][N/2+2], T[N/2+2][N/2-4]);
-    printf("[%d][%d] M: %.2f T: %.2f\n", N-5, N-3, M[N-5][N-3], T[N-3][N-5]);
+void freeHierarchy(Hierarchy* h) {
+    MPI_Win_free(&h->input_win);
+    MPI_Win_free(&h->output_win);
+    if(h->leader_comm!=MPI_COMM_NULL) {
+        MPI_Comm_free(&h->leader_comm);
+    }
+    MPI_Comm_free(&h->node_comm);
+    free(h->node_of);
 }
 /*
- *  Name: clearCache
- *  Function that tries to free memory for the various chunk of memory in order to minimize the number of more efficient simulation. This isn't guarantee to always work, but it brought less outliers.
- *  Input:
- *      dimCache (long long int) - Dimension of the cache we would like to clear
- *  Output: none
+ * Name: matTransposeMPIHierarchical
+ * Node-aware transposition of a matrix distributed by rows that leaves also the transposed matrix distributed by
+ * rows, before gathering it on rank 0. It works on two levels:
+ *  1. each process puts its slab (scattered as in matTransposeMPIAllGather) in the shared memory of its node;
+ *  2. the leader of each node packs, for every other node, the columns of all the slabs of its node that belong
+ *     to the processes of that node, already transposed, and the leaders exchange them with a single
+ *     MPI_Alltoallv, so among nodes travels one message per pair of nodes and not one per pair of processes;
+ *  3. the leader unpacks the received data directly in the shared slabs of the transposed matrix of its processes,
+ *     which copy them in T and send them to rank 0 with one MPI_Gatherv.
+ * The process p owns the rows p*rows..(p+1)*rows-1 of the start matrix and p*cols..(p+1)*cols-1 of the transposed one.
+ *
+ * Input:
+ *      M (float**) - The local slab of the start matrix (rows x C)
+ *      T (float**) - The local slab of the transposed matrix (cols x N)
+ *      rank (int) - The rank of the current MPI process
+ *      N (int) - The number of rows of the matrix (N x C)
+ *      C (int) - The number of columns of the matrix
+ *      rows (int) - The number of rows of the start matrix of each process
+ *      cols (int) - The number of rows of the transposed matrix of each process
+ *      sending (DataCommunicate) - Counts and displacements of the scatter of the slabs
+ *      receiving (DataCommunicate) - Counts and displacements of the gather of the transposed slabs
+ *      sender (Communicator2D) - The type of a slab of the start matrix
+ *
+ * Output: none
  */
-void clearAllCache(void) {
-    float* cacheL1d, *cacheL1i, *cacheL2, *cacheL3;
-    if (posix_memalign((void**)&cacheL1d, 64, CACHESIZEL1D) != 0 ||
-            posix_memalign((void**)&cacheL1i, 64, CACHESIZEL1I) != 0 ||
-            posix_memalign((void**)&cacheL2, 64, CACHESIZEL2) != 0 ||
-            posix_memalign((void**)&cacheL3, 64, CACHESIZEL3) != 0) {
-            fprintf(stderr, "Failed to allocate aligned memory\n");
+void matTransposeMPIHierarchical (float** M, float** T, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender) {
+    Hierarchy* h=&hierarchy;
+    int num_procs, i, p, q, c, r;
+    MPI_Comm_size(actual_comm, &num_procs);
+    PHASE_BEGIN(PHASE_SCATTER);
+    MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, sender.resized_type, &(M[0][0]), rows*C, MPI_FLOAT, 0, actual_comm);
+    //1. Aggregation of the slabs of the node in shared memory
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, h->input_win);
+    memcpy(h->input, &(M[0][0]), sizeof(float)*rows*C);
+    MPI_Win_sync(h->input_win);
+    MPI_Barrier(h->node_comm);
+    MPI_Win_sync(h->input_win);
+    PHASE_END(PHASE_SCATTER);
+    //2. Exchange among the leaders of the nodes
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, h->output_win);
+    if(h->leader_comm!=MPI_COMM_NULL) {
+        int* procs_of=calloc(h->nodes, sizeof(int));
+        int* send_counts=malloc(sizeof(int)*h->nodes);
+        int* send_displs=malloc(sizeof(int)*h->nodes);
+        int* recv_counts=malloc(sizeof(int)*h->nodes);
+        int* recv_displs=malloc(sizeof(int)*h->nodes);
+        float** slabs=malloc(sizeof(float*)*num_procs);
+        if(procs_of==NULL || send_counts==NULL || send_displs==NULL || recv_counts==NULL || recv_displs==NULL || slabs==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
             exit(1);
         }
-    int i;
-    for (i = 0; i < CACHESIZEL1D / sizeof(float); ++i) {
-        cacheL1d[i] = 1.0f;
-    }
-    for (i = 0; i < CACHESIZEL1I / sizeof(float); ++i) {
-        cacheL1i[i] = 1.0f;
-    }
-    for (i = 0; i < CACHESIZEL2 / sizeof(float); ++i) {
-        cacheL2[i] = 1.0f;
-    }
-    for (i = 0; i < CACHESIZEL3 / sizeof(float); ++i) {
-        cacheL3[i] = 1.0f;
+        int me=h->node_of[rank];
+        for (p=0; p<num_procs; p++) {
+            procs_of[h->node_of[p]]++;
+        }
+        //Address of the shared slabs of the processes of the node, in the same order of the ranks
+        int local=0;
+        for (p=0; p<num_procs; p++) {
+            slabs[p]=NULL;
+            if(h->node_of[p]==me) {
+                MPI_Aint size;
+                int disp_unit;
+                MPI_Win_shared_query(h->input_win, local, &size, &disp_unit, &slabs[p]);
+                local++;
+            }
+        }
+        int send_total=0, recv_total=0;
+        for (i=0; i<h->nodes; i++) {
+            send_counts[i]=procs_of[me]*rows*procs_of[i]*cols;
+            recv_counts[i]=procs_of[i]*rows*procs_of[me]*cols;
+            send_displs[i]=send_total;
+            recv_displs[i]=recv_total;
+            send_total+=send_counts[i];
+            recv_total+=recv_counts[i];
+        }
+        float* send_buffer=malloc(sizeof(float)*MAX(send_total, 1));
+        float* recv_buffer=malloc(sizeof(float)*MAX(recv_total, 1));
+        if(send_buffer==NULL || recv_buffer==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        //Packing: for each node, its processes q, their transposed rows c, the slabs p of this node
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        for (i=0; i<h->nodes; i++) {
+            float* packed=&send_buffer[send_displs[i]];
+            for (q=0; q<num_procs; q++) {
+                if(h->node_of[q]!=i) {
+                    continue;
+                }
+                for (c=q*cols; c<(q+1)*cols; c++) {
+                    for (p=0; p<num_procs; p++) {
+                        if(h->node_of[p]!=me) {
+                            continue;
+                        }
+                        for (r=0; r<rows; r++) {
+                            *(packed++)=slabs[p][r*C+c];
+                        }
+                    }
+                }
+            }
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        MPI_Alltoallv(send_buffer, send_counts, send_displs, MPI_FLOAT, recv_buffer, recv_counts, recv_displs, MPI_FLOAT, h->leader_comm);
+        PHASE_END(PHASE_EXCHANGE);
+        //Unpacking in the shared transposed slabs of the processes of the node
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        local=0;
+        for (q=0; q<num_procs; q++) {
+            if(h->node_of[q]!=me) {
+                continue;
+            }
+            MPI_Aint size;
+            int disp_unit;
+            float* out;
+            MPI_Win_shared_query(h->output_win, local++, &size, &disp_unit, &out);
+            int before=0;//Transposed rows of the previous processes of this node
+            for (p=0; p<q; p++) {
+                if(h->node_of[p]==me) {
+                    before++;
+                }
+            }
+            for (i=0; i<h->nodes; i++) {
+                float* packed=&recv_buffer[recv_displs[i]+before*cols*procs_of[i]*rows];
+                for (c=0; c<cols; c++) {
+                    for (p=0; p<num_procs; p++) {
+                        if(h->node_of[p]!=i) {
+                            continue;
+                        }
+                        memcpy(&out[c*N+p*rows], packed, sizeof(float)*rows);
+                        packed+=rows;
+                    }
+                }
+            }
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+        free(send_buffer);
+        free(recv_buffer);
+        free(slabs);
+        free(procs_of);
+        free(send_counts);
+        free(send_displs);
+        free(recv_counts);
+        free(recv_displs);
     }
-    free(cacheL1d);
-    free(cacheL1i);
-    free(cacheL2);
-    free(cacheL3);
+    //3. Redistribution of the transposed slabs inside the node
+    PHASE_BEGIN(PHASE_GATHER);
+    MPI_Win_sync(h->output_win);
+    MPI_Barrier(h->node_comm);
+    MPI_Win_sync(h->output_win);
+    memcpy(&(T[0][0]), h->output, sizeof(float)*cols*N);
+    MPI_Win_unlock_all(h->output_win);
+    MPI_Win_unlock_all(h->input_win);
+    MPI_Gatherv(&(T[0][0]), cols*N, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
+    PHASE_END(PHASE_GATHER);
 }
 /*
- *  Name: getSequential
- *  Function that retrieves the sequential execution time for a given dimension and test from a file.
- *  Input:
- *      dim (int) - Dimension for which we are retrieving the sequential time
- *      test (int) - Test identifier to filter the relevant entry
- *      scaling (int) - Scaling mode defining 0. Strong 1. Weak
- *  Output:
- *      double - Returns the average time for the sequential execution. If not found in the file, it returns 0.00
+ * Name: exchangeBlocks
+ * All-to-all exchange of equal blocks among the processes of actual_comm: the block i of sendbuf goes to the
+ * process i and the block received from the process i is written in the block i of recvbuf. The schedule is
+ * selected at runtime, in order to choose the latency-optimal one for small blocks and the bandwidth-optimal
+ * one for big blocks:
+ *  ALLTOALL - MPI_Alltoall, the schedule is left to the library
+ *  PAIRWISE - P-1 steps, at step k exchange with rank^k (P power of 2) or send to rank+k and receive from rank-k
+ *  BRUCK    - log2(P) steps, at step k are forwarded to rank+k all the blocks with the bit k set in their
+ *             distance, after a local rotation that is undone at the end (few big messages for small blocks)
+ *  EKLUNDH  - log2(P) steps of recursive halving (P power of 2), at step d the process exchanges with rank^d
+ *             the half of its blocks destined to the other half of the hypercube, like the butterfly of the
+ *             recursive transposition of Eklundh
+ * The point-to-point schedules use exchangeFloats, so they are compressed when enabled. The schedule OVERLAP
+ * doesn't go through here, it packs and exchanges the blocks together (see transposeOverlapped).
+ *
+ * Input:
+ *      sendbuf (float*) - The P blocks to send
+ *      recvbuf (float*) - The P blocks received
+ *      block (int) - The number of floats of each block
+ *      algorithm (Exchange) - The schedule of the exchange
+ *
+ * Output: none
  */
-double getSequential(const int dim, const char* code, const int mode, const int test, const int scaling) {
-    char line[256];
-    int findex, fmode, fdimension, ftest, fsamples, fthreads, fscaling;
-    char fcompile[20];
-    double favg_time=0.0, fseq_time, fspeedup, fefficiency;
-    FILE* file=fopen(FILENAMESEQ, "a+");
-    if(file==NULL) {
-        fprintf(stderr, "Couldn't open or create file %s\n", FILENAMESEQ);
-        exit(1);
-    }
-    bool found=false;
-    fgets(line, sizeof(line), file);
-    while(!found && (fscanf(file, "%d %s %d %d %d %d %d %d %lf %lf %lf %lf%%", &findex, fcompile, &fmode, &fdimension, &ftest,
-          &fsamples, &fthreads, &fscaling, &favg_time, &fseq_time,
-          &fspeedup, &fefficiency)==12)) {
-        if(fmode==mode && (strcmp(fcompile, code)==0) && fdimension==dim && ftest==test && fscaling==scaling) {
-            found=true;
+void exchangeBlocks(float* sendbuf, float* recvbuf, int block, Exchange algorithm) {
+    int rank, num_procs, i, k;
+    MPI_Comm_rank(actual_comm, &rank);
+    MPI_Comm_size(actual_comm, &num_procs);
+    size_t bytes=sizeof(float)*block;
+    bool power2=(num_procs&(num_procs-1))==0;
+    switch (algorithm) {
+        case ALLTOALL:
+            MPI_Alltoall(sendbuf, block, MPI_FLOAT, recvbuf, block, MPI_FLOAT, actual_comm);
+            break;
+        case PAIRWISE: {
+            memcpy(&recvbuf[(size_t)rank*block], &sendbuf[(size_t)rank*block], bytes);
+            for (k=1; k<num_procs; k++) {
+                int dest=power2 ? (rank^k) : (rank+k)%num_procs;
+                int source=power2 ? (rank^k) : (rank-k+num_procs)%num_procs;
+                exchangeFloats(&sendbuf[(size_t)dest*block], dest, &recvbuf[(size_t)source*block], source, block, k);
+            }
+        }
+        break;
+        case BRUCK: {
+            float* rotated=malloc(bytes*num_procs);
+            float* packed=malloc(bytes*((num_procs+1)/2));
+            float* received=malloc(bytes*((num_procs+1)/2));
+            if(rotated==NULL || packed==NULL || received==NULL) {
+                printf("Memory allocation failed\n");
+                MPI_Finalize();
+                exit(1);
+            }
+            //The block i of rotated is the one for the process at distance i
+            for (i=0; i<num_procs; i++) {
+                memcpy(&rotated[(size_t)i*block], &sendbuf[(size_t)((rank+i)%num_procs)*block], bytes);
+            }
+            for (k=1; k<num_procs; k<<=1) {
+                int count=0;
+                for (i=0; i<num_procs; i++) {
+                    if(i&k) {
+                        memcpy(&packed[(size_t)(count++)*block], &rotated[(size_t)i*block], bytes);
+                    }
+                }
+                exchangeFloats(packed, (rank+k)%num_procs, received, (rank-k+num_procs)%num_procs, count*block, k);
+                count=0;
+                for (i=0; i<num_procs; i++) {
+                    if(i&k) {
+                        memcpy(&rotated[(size_t)i*block], &received[(size_t)(count++)*block], bytes);
+                    }
+                }
+            }
+            //Now the block i comes from the process at distance -i
+            for (i=0; i<num_procs; i++) {
+                memcpy(&recvbuf[(size_t)((rank-i+num_procs)%num_procs)*block], &rotated[(size_t)i*block], bytes);
+            }
+            free(rotated);
+            free(packed);
+            free(received);
+        }
+        break;
+        case EKLUNDH: {
+            float* packed=malloc(bytes*MAX(num_procs/2, 1));
+            float* received=malloc(bytes*MAX(num_procs/2, 1));
+            if(packed==NULL || received==NULL) {
+                printf("Memory allocation failed\n");
+                MPI_Finalize();
+                exit(1);
+            }
+            //The slot s holds the block from the source with the processed bits of s to the destination with the others
+            memcpy(recvbuf, sendbuf, bytes*num_procs);
+            int d;
+            for (d=num_procs/2; d>=1; d>>=1) {
+                int partner=rank^d;
+                int count=0;
+                for (i=0; i<num_procs; i++) {
+                    if((i&d)!=(rank&d)) {
+                        memcpy(&packed[(size_t)(count++)*block], &recvbuf[(size_t)i*block], bytes);
+                    }
+                }
+                exchangeFloats(packed, partner, received, partner, count*block, d);
+                count=0;
+                for (i=0; i<num_procs; i++) {
+                    if((i&d)!=(rank&d)) {
+                        memcpy(&recvbuf[(size_t)i*block], &received[(size_t)(count++)*block], bytes);
+                    }
+                }
+            }
+            free(packed);
+            free(received);
         }
+        break;
+        default:
+            //OVERLAP is done by transposeOverlapped
+            break;
     }
-    fclose(file);
-    if(found) {
-        return favg_time;
+}
+/*
+ * Name: matTransposeMPIExchange
+ * Transposition of a matrix distributed by rows that leaves also the transposed matrix distributed by rows, with an
+ * explicit all-to-all exchange. The slabs are scattered from rank 0 with one MPI_Scatterv, transposed and exchanged
+ * as in matTransposeMPIDistributed (packed by destination, exchanged with the schedule chosen by --exchange and
+ * copied in the slab of the transposed matrix), then the slabs are gathered on rank 0 with one MPI_Gatherv.
+ *
+ * Input:
+ *      M (float**) - The local slab of the start matrix (rows x C)
+ *      T (float**) - The local slab of the transposed matrix (cols x N)
+ *      rank (int) - The rank of the current MPI process
+ *      N (int) - The number of rows of the matrix (N x C)
+ *      C (int) - The number of columns of the matrix
+ *      rows (int) - The number of rows of the start matrix of each process
+ *      cols (int) - The number of rows of the transposed matrix of each process
+ *      sending (DataCommunicate) - Counts and displacements of the scatter of the slabs
+ *      receiving (DataCommunicate) - Counts and displacements of the gather of the transposed slabs
+ *      sender (Communicator2D) - The type of a slab of the start matrix
+ *
+ * Output: none
+ */
+void matTransposeMPIExchange (float** M, float** T, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender) {
+    PHASE_BEGIN(PHASE_SCATTER);
+    MPI_Scatterv(globalsendptr, sending.counts, sending.displacements, sender.resized_type, &(M[0][0]), rows*C, MPI_FLOAT, 0, actual_comm);
+    PHASE_END(PHASE_SCATTER);
+    //The scattered slabs are transposed as the ones that exist only distributed
+    matTransposeMPIDistributed(M, T, rows, cols);
+    PHASE_BEGIN(PHASE_GATHER);
+    MPI_Gatherv(&(T[0][0]), cols*N, MPI_FLOAT, globalrecvptr, receiving.counts, receiving.displacements, MPI_FLOAT, 0, actual_comm);
+    PHASE_END(PHASE_GATHER);
+}
+/*
+ * Name: matTransposeMPIDistributed
+ * Transposition of a matrix that exists only distributed by rows, without the matrices of rank 0: each process
+ * owns its rows x C slab of the start matrix and ends with its cols x N slab of the transposed one. The slab is
+ * transposed while packing, for every process q, the columns q*cols..(q+1)*cols-1 in a contiguous block, the
+ * blocks are exchanged with the schedule chosen by --exchange (see exchangeBlocks, or transposeOverlapped for
+ * --exchange=overlap) and the received rows are copied in the slab of the transposed matrix. There is no scatter and no gather, so in weak scaling the memory
+ * and the data moved by a process don't grow with the processes.
+ *
+ * Input:
+ *      M (float**) - The local slab of the start matrix (rows x C)
+ *      T (float**) - The local slab of the transposed matrix (cols x N)
+ *      rows (int) - The number of rows of the start matrix of each process
+ *      cols (int) - The number of rows of the transposed matrix of each process
+ *
+ * Output: none
+ */
+void matTransposeMPIDistributed (float** M, float** T, int rows, int cols) {
+    int num_procs, p, c, r;
+    MPI_Comm_size(actual_comm, &num_procs);
+    if(options.exchange==OVERLAP) {
+        transposeOverlapped(M, T, rows, cols);
     }
     else {
-        return 0.00;
+        int block=rows*cols;
+        float* send_buffer=malloc(sizeof(float)*block*num_procs);
+        float* recv_buffer=malloc(sizeof(float)*block*num_procs);
+        if(send_buffer==NULL || recv_buffer==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        //Local transposition packed by destination: the block p is cols x rows
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        for (p=0; p<num_procs; p++) {
+            float* packed=&send_buffer[(size_t)p*block];
+            for (c=0; c<cols; c++) {
+                for (r=0; r<rows; r++) {
+                    packed[c*rows+r]=M[r][p*cols+c];
+                }
+            }
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        exchangeBlocks(send_buffer, recv_buffer, block, options.exchange);
+        PHASE_END(PHASE_EXCHANGE);
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        for (p=0; p<num_procs; p++) {
+            for (c=0; c<cols; c++) {
+                memcpy(&T[c][p*rows], &recv_buffer[(size_t)p*block+c*rows], sizeof(float)*rows);
+            }
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+        free(send_buffer);
+        free(recv_buffer);
     }
 }
 /*
- *  Name: openFile
- *  Function that opens a file and appends performance data. Depending on the mode and type, it computes speedup and efficiency, then writes on the file the input parameters and calculated information. Writes performance data to the file. If the file is empty, it writes a header before appending data.
- *  Input:
- *      filename (const char*) - The name of the file to open.
+ * Name: transposeOverlapped
+ * All-to-all transposition of the slabs of rows of --exchange=overlap, with non-blocking transfers overlapped with
+ * the local transposition: the receives of the P-1 blocks are posted first, the block of each destination (the
+ * process at distance 1, 2, ... as in the pairwise schedule) is sent with MPI_Isend as soon as it is packed while
+ * the next one is packed, and the received blocks are copied in the slab of the transposed matrix in the order
+ * they arrive. The requests go through the progress engine (see startProgress): with --progress=1 a thread
+ * completes them while the main one computes, otherwise they advance only inside the MPI calls. The time from the
+ * first request posted to the last one completed and the time the main thread waited for them are added to
+ * overlap_stats. The blocks aren't compressed.
+ *
+ * Input:
+ *      M (float**) - The local slab of the start matrix (rows x C)
+ *      T (float**) - The local slab of the transposed matrix (cols x N)
+ *      rows (int) - The number of rows of the start matrix of each process
+ *      cols (int) - The number of rows of the transposed matrix of each process
+ *
+ * Output: none
+ */
+void transposeOverlapped(float** M, float** T, int rows, int cols) {
+    int rank, num_procs, k, c, r;
+    MPI_Comm_rank(actual_comm, &rank);
+    MPI_Comm_size(actual_comm, &num_procs);
+    int block=rows*cols;
+    float* send_buffer=malloc(sizeof(float)*block*num_procs);
+    float* recv_buffer=malloc(sizeof(float)*block*num_procs);
+    if(send_buffer==NULL || recv_buffer==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    MPI_Request request;
+    double exposed=0.0;
+    const double posted=MPI_Wtime();
+    //The request k-1 receives the block of the process at distance -k
+    for (k=1; k<num_procs; k++) {
+        const int source=(rank-k+num_procs)%num_procs;
+        MPI_Irecv(&recv_buffer[(size_t)source*block], block, MPI_FLOAT, source, 0, actual_comm, &request);
+        progressAdd(request);
+    }
+    //The own block is packed last, while the others are travelling
+    for (k=1; k<=num_procs; k++) {
+        const int dest=(rank+k)%num_procs;
+        float* packed=&send_buffer[(size_t)dest*block];
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        for (c=0; c<cols; c++) {
+            for (r=0; r<rows; r++) {
+                packed[c*rows+r]=M[r][dest*cols+c];
+            }
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+        if(dest!=rank) {
+            MPI_Isend(packed, block, MPI_FLOAT, dest, 0, actual_comm, &request);
+            progressAdd(request);
+        }
+    }
+    PHASE_BEGIN(PHASE_TRANSPOSE);
+    for (c=0; c<cols; c++) {
+        memcpy(&T[c][rank*rows], &send_buffer[(size_t)rank*block+c*rows], sizeof(float)*rows);
+    }
+    PHASE_END(PHASE_TRANSPOSE);
+    for (k=1; k<num_procs; k++) {
+        double wait_start=MPI_Wtime();
+        PHASE_BEGIN(PHASE_EXCHANGE);
+        const int source=(rank-1-progressWaitAny(0, num_procs-1)+num_procs)%num_procs;
+        PHASE_END(PHASE_EXCHANGE);
+        exposed+=MPI_Wtime()-wait_start;
+        PHASE_BEGIN(PHASE_TRANSPOSE);
+        for (c=0; c<cols; c++) {
+            memcpy(&T[c][source*rows], &recv_buffer[(size_t)source*block+c*rows], sizeof(float)*rows);
+        }
+        PHASE_END(PHASE_TRANSPOSE);
+    }
+    //The sends are completed before their buffer is freed
+    double wait_start=MPI_Wtime();
+    PHASE_BEGIN(PHASE_EXCHANGE);
+    const double completed=progressWaitAll();
+    PHASE_END(PHASE_EXCHANGE);
+    exposed+=MPI_Wtime()-wait_start;
+    if(num_procs>1) {
+        const double communication=MAX(completed-posted, 0.0);
+        overlap_stats.exchanges++;
+        overlap_stats.communication+=communication;
+        overlap_stats.exposed+=MIN(exposed, communication);
+    }
+    free(send_buffer);
+    free(recv_buffer);
+}
+/*
+ * Name: checkSymDistributed
+ * Verifies if a matrix distributed by rows is symmetric. A process doesn't have the rows symmetric to its own,
+ * so the check is done after matTransposeMPIDistributed: the matrix is symmetric if every process has the slab
+ * of the transposed matrix equal to its slab of the start one. A rectangular matrix (like the one of weak
+ * scaling) can't be symmetric, so in that case no check is done.
+ *
+ * Input:
+ *      M (float**) - The local slab of the start matrix (rows x C)
+ *      T (float**) - The local slab of the transposed matrix (rows x N when N==C)
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *      rows (int) - The number of rows of the start matrix of each process
+ *
+ * Output:
+ *      bool - Returns `true` if the matrix is symmetric across all processes, otherwise returns `false`.
+ */
+bool checkSymDistributed (float** M, float** T, int N, int C, int rows) {
+    if(N!=C) {
+        return false;
+    }
+    PHASE_BEGIN(PHASE_CHECK);
+    int symmetric=1, global;
+    int i, j;
+    for (i=0; i<rows && symmetric==1; i++) {
+        for (j=0; j<C && symmetric==1; j++) {
+            if (ABS_DIFF(M[i][j], T[i][j])>ERROR) {
+                symmetric=0;
+            }
+        }
+    }
+    MPI_Allreduce(&symmetric, &global, 1, MPI_INT, MPI_MIN, actual_comm);
+    PHASE_END(PHASE_CHECK);
+    return (global==1);
+}
+/*
+ * Name: createSparse
+ * Allocates an empty slab of a sparse matrix in CSR, with room for capacity nonzeros (grown by reserveSparse).
+ *
+ * Input:
+ *      S (Sparse*) - The slab to allocate
+ *      rows (int) - The number of rows of the slab
+ *      first (int) - The global index of the first row of the slab
+ *      capacity (int) - The nonzeros allocated
+ *
+ * Output: none
+ */
+void createSparse(Sparse* S, int rows, int first, int capacity) {
+    S->rows=rows;
+    S->first=first;
+    S->nnz=0;
+    S->capacity=MAX(capacity, 1);
+    S->row_ptr=(int*)calloc(rows+1, sizeof(int));
+    S->col_idx=(int*)malloc(sizeof(int)*S->capacity);
+    S->values=(float*)malloc(sizeof(float)*S->capacity);
+    if(S->row_ptr==NULL || S->col_idx==NULL || S->values==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+}
+/*
+ * Name: reserveSparse
+ * Grows the arrays of the nonzeros of a slab to at least capacity elements (doubling, to append in amortized
+ * constant time), keeping the ones already stored.
+ *
+ * Input:
+ *      S (Sparse*) - The slab
+ *      capacity (int) - The nonzeros needed
+ *
+ * Output: none
+ */
+void reserveSparse(Sparse* S, int capacity) {
+    if(capacity<=S->capacity) {
+        return;
+    }
+    S->capacity=MAX(capacity, 2*S->capacity);
+    int* col_idx=(int*)realloc(S->col_idx, sizeof(int)*S->capacity);
+    float* values=(float*)realloc(S->values, sizeof(float)*S->capacity);
+    if(col_idx==NULL || values==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    S->col_idx=col_idx;
+    S->values=values;
+}
+/*
+ * Name: freeSparse
+ * Frees the arrays of a slab allocated by createSparse.
+ *
+ * Input:
+ *      S (Sparse*) - The slab to free
+ *
+ * Output: none
+ */
+void freeSparse(Sparse* S) {
+    free(S->row_ptr);
+    free(S->col_idx);
+    free(S->values);
+    S->row_ptr=NULL;
+    S->col_idx=NULL;
+    S->values=NULL;
+    S->nnz=S->capacity=0;
+}
+/*
+ * Name: sliceStart
+ * First index of the slice of the process p when n indices are split among the processes, the first n%num_procs
+ * with one more (the same split of the rows done by createPlan).
+ *
+ * Input:
+ *      n (int) - The number of indices
+ *      num_procs (int) - The number of processes
+ *      p (int) - The process
+ *
+ * Output:
+ *      int - The first index of the slice of p (n for p==num_procs)
+ */
+int sliceStart(int n, int num_procs, int p) {
+    return p*(n/num_procs)+MIN(p, n%num_procs);
+}
+/*
+ * Name: sliceOwner
+ * Process owning an index when n indices are split as in sliceStart, without searching among the slices.
+ *
+ * Input:
+ *      index (int) - The index
+ *      n (int) - The number of indices
+ *      num_procs (int) - The number of processes
+ *
+ * Output:
+ *      int - The process whose slice contains index
+ */
+int sliceOwner(int index, int n, int num_procs) {
+    const int q=n/num_procs, r=n%num_procs;
+    const int long_part=r*(q+1);//Indices of the slices with one more
+    return (index<long_part) ? index/(q+1) : r+(index-long_part)/q;
+}
+/*
+ * Name: initializeSparse
+ * Generates the slab of rows of a sparse matrix: the rows are generated dense by initializeMatrix, SPARSE_CHUNK at
+ * a time, and only the elements kept by the mask of --density are compressed in CSR (without the zeros of the
+ * test, like the ones out of the band of BANDED). The mask keeps always the tridiagonal (so the mismatch of WORST
+ * too) and the pairs of the mismatches of NEAR_SYM, and the other elements (i, j) with a probability given by the
+ * pair (max, min), so it's symmetric and the symmetric tests stay symmetric, and as the values it doesn't depend on
+ * the processes.
+ *
+ * Input:
+ *      S (Sparse*) - The slab, created with its rows and its first row
+ *      test (Test) - The test of the values
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *
+ * Output: none
+ */
+void initializeSparse(Sparse* S, Test test, int N, int C) {
+    const unsigned long long mask_seed=~mixBits((test==RANDOM) ? options.seed : STATIC_SEED);
+    const unsigned long long threshold=(unsigned long long)(options.density/100*SPARSE_SCALE);
+    const int chunk=MIN(SPARSE_CHUNK, MAX(S->rows, 1));
+    float** dense=NULL;
+    int start, i, j, k;
+    //Positions (row, column) of the mismatches of NEAR_SYM, which the mask can't drop
+    long long mismatches[NEAR_SYM_MISMATCHES][2];
+    const int n_mismatches=(test==NEAR_SYM && N==C && N>1) ? NEAR_SYM_MISMATCHES : 0;
+    for (k=0; k<n_mismatches; k++) {
+        nearSymMismatch(mixBits(STATIC_SEED), k, N, &mismatches[k][0], &mismatches[k][1]);
+    }
+    create2DFloatMatrix(&dense, chunk, C);
+    S->nnz=0;
+    S->row_ptr[0]=0;
+    for (start=0; start<S->rows; start+=chunk) {
+        const int x=MIN(chunk, S->rows-start);
+        initializeMatrix(dense, test, S->first+start, x, N, C);
+        for (i=0; i<x; i++) {
+            const unsigned long long r=(unsigned long long)(S->first+start+i);
+            reserveSparse(S, S->nnz+C);
+            for (j=0; j<C; j++) {
+                const unsigned long long high=MAX(r, (unsigned long long)j), low=MIN(r, (unsigned long long)j);
+                bool kept=(high-low<=1 || mixBits(mask_seed^((high<<32)|low))%SPARSE_SCALE<threshold);
+                for (k=0; k<n_mismatches && !kept; k++) {
+                    kept=(high==(unsigned long long)mismatches[k][0] && low==(unsigned long long)mismatches[k][1]);
+                }
+                if(dense[i][j]!=0.0f && kept) {
+                    S->col_idx[S->nnz]=j;
+                    S->values[S->nnz]=dense[i][j];
+                    S->nnz++;
+                }
+            }
+            S->row_ptr[start+i+1]=S->nnz;
+        }
+    }
+    free2DMemory(&dense);
+}
+/*
+ * Name: matTransposeMPISparse
+ * Transposition of a sparse matrix distributed by slabs of rows in CSR, giving the transposed matrix distributed
+ * in the same way (the process p gets the rows of T that are its slice of the columns). The nonzeros are counted
+ * per destination (owner of their column), packed by a counting sort in (col, row, value) triplets, whose counts
+ * are exchanged with MPI_Alltoall and the triplets with MPI_Alltoallv, and finally the received triplets are
+ * sorted by column with a counting sort in the CSR of the transposed slab. The triplets of a destination leave in
+ * increasing row and the sources are in increasing rank, so the columns of each transposed row come out sorted.
+ * Only the nonzeros are moved, not the N x C elements.
+ *
+ * Input:
+ *      A (const Sparse*) - The local slab of the start matrix
+ *      T (Sparse*) - The local slab of the transposed matrix, created with its rows and its first row
+ *      C (int) - The number of columns of the start matrix
+ *
+ * Output: none
+ */
+void matTransposeMPISparse (const Sparse* A, Sparse* T, int C) {
+    int num_procs, p, i, k;
+    MPI_Comm_size(actual_comm, &num_procs);
+    int* counts=(int*)calloc(5*num_procs, sizeof(int));
+    Triplet* send_buffer=(Triplet*)malloc(sizeof(Triplet)*MAX(A->nnz, 1));
+    if(counts==NULL || send_buffer==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    int* send_counts=counts;
+    int* send_displs=counts+num_procs;
+    int* recv_counts=counts+2*num_procs;
+    int* recv_displs=counts+3*num_procs;
+    int* next=counts+4*num_procs;
+    //Triplet of 3 elements of 4 bytes, described field by field for heterogeneous processes
+    MPI_Datatype triplet_type;
+    int lengths[3]={1, 1, 1};
+    MPI_Aint displacements[3]={offsetof(Triplet, col), offsetof(Triplet, row), offsetof(Triplet, value)};
+    MPI_Datatype types[3]={MPI_INT, MPI_INT, MPI_FLOAT};
+    MPI_Type_create_struct(3, lengths, displacements, types, &triplet_type);
+    MPI_Type_commit(&triplet_type);
+    //Counting sort of the nonzeros by destination
+    PHASE_BEGIN(PHASE_TRANSPOSE);
+    for (k=0; k<A->nnz; k++) {
+        send_counts[sliceOwner(A->col_idx[k], C, num_procs)]++;
+    }
+    for (p=1; p<num_procs; p++) {
+        send_displs[p]=send_displs[p-1]+send_counts[p-1];
+    }
+    memcpy(next, send_displs, sizeof(int)*num_procs);
+    for (i=0; i<A->rows; i++) {
+        for (k=A->row_ptr[i]; k<A->row_ptr[i+1]; k++) {
+            Triplet* triplet=&send_buffer[next[sliceOwner(A->col_idx[k], C, num_procs)]++];
+            triplet->col=A->col_idx[k];
+            triplet->row=A->first+i;
+            triplet->value=A->values[k];
+        }
+    }
+    PHASE_END(PHASE_TRANSPOSE);
+    PHASE_BEGIN(PHASE_EXCHANGE);
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, actual_comm);
+    for (p=1; p<num_procs; p++) {
+        recv_displs[p]=recv_displs[p-1]+recv_counts[p-1];
+    }
+    const int received=recv_displs[num_procs-1]+recv_counts[num_procs-1];
+    Triplet* recv_buffer=(Triplet*)malloc(sizeof(Triplet)*MAX(received, 1));
+    if(recv_buffer==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    MPI_Alltoallv(send_buffer, send_counts, send_displs, triplet_type, recv_buffer, recv_counts, recv_displs, triplet_type, actual_comm);
+    PHASE_END(PHASE_EXCHANGE);
+    //Counting sort of the received nonzeros by column, the rows of the transposed slab
+    PHASE_BEGIN(PHASE_TRANSPOSE);
+    reserveSparse(T, received);
+    T->nnz=received;
+    memset(T->row_ptr, 0, sizeof(int)*(T->rows+1));
+    for (k=0; k<received; k++) {
+        T->row_ptr[recv_buffer[k].col-T->first+1]++;
+    }
+    for (i=0; i<T->rows; i++) {
+        T->row_ptr[i+1]+=T->row_ptr[i];
+    }
+    //row_ptr[i] is used as the next free position of the row i, then shifted back
+    for (k=0; k<received; k++) {
+        const int position=T->row_ptr[recv_buffer[k].col-T->first]++;
+        T->col_idx[position]=recv_buffer[k].row;
+        T->values[position]=recv_buffer[k].value;
+    }
+    for (i=T->rows; i>0; i--) {
+        T->row_ptr[i]=T->row_ptr[i-1];
+    }
+    T->row_ptr[0]=0;
+    PHASE_END(PHASE_TRANSPOSE);
+    MPI_Type_free(&triplet_type);
+    free(send_buffer);
+    free(recv_buffer);
+    free(counts);
+}
+/*
+ * Name: checkSymSparse
+ * Verifies if a sparse matrix distributed by rows is symmetric, after matTransposeMPISparse as checkSymDistributed:
+ * the matrix is symmetric if every process has the transposed slab with the same nonzeros (positions and values)
+ * of its slab of the start one. A rectangular matrix can't be symmetric, so in that case no check is done.
+ *
+ * Input:
+ *      A (const Sparse*) - The local slab of the start matrix
+ *      T (const Sparse*) - The local slab of the transposed matrix (the same rows of A when N==C)
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *
+ * Output:
+ *      bool - Returns `true` if the matrix is symmetric across all processes, otherwise returns `false`.
+ */
+bool checkSymSparse (const Sparse* A, const Sparse* T, int N, int C) {
+    if(N!=C) {
+        return false;
+    }
+    PHASE_BEGIN(PHASE_CHECK);
+    int symmetric=(A->nnz==T->nnz && memcmp(A->row_ptr, T->row_ptr, sizeof(int)*(A->rows+1))==0) ? 1 : 0;
+    int global, k;
+    for (k=0; k<A->nnz && symmetric==1; k++) {
+        if (A->col_idx[k]!=T->col_idx[k] || ABS_DIFF(A->values[k], T->values[k])>ERROR) {
+            symmetric=0;
+        }
+    }
+    MPI_Allreduce(&symmetric, &global, 1, MPI_INT, MPI_MIN, actual_comm);
+    PHASE_END(PHASE_CHECK);
+    return (global==1);
+}
+/*
+ * Name: usePacked
+ * Tells if a configuration stores its matrix packed with --packed=1: only the symmetric test is known to be
+ * symmetric before the check, the matrix has to be square and only the distributed mode, where every process owns
+ * just the packed rows of its slab, takes it as input (createPlan rejects --packed=1 with the other modes).
+ *
+ * Input:
+ *      mode (Mode) - The execution mode
+ *      test (Test) - The test of the matrix
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *
+ * Output:
+ *      bool - True if the matrix is stored packed
+ */
+bool usePacked(Mode mode, Test test, int N, int C) {
+    return options.packed==1 && test==SYM && N==C && mode==MPI_DISTRIBUTED;
+}
+/*
+ * Name: createPacked
+ * Allocates the rows first..first+rows-1 of the packed lower triangle of a symmetric matrix, stored one after the
+ * other (PACKED_OFFSET(first+rows)-PACKED_OFFSET(first) floats, about half of the full rows for the whole matrix).
+ *
+ * Input:
+ *      first (int) - The first row
+ *      rows (int) - The number of rows
+ *
+ * Output:
+ *      float* - The packed rows
+ */
+float* createPacked(int first, int rows) {
+    float* P=(float*)malloc(sizeof(float)*MAX(PACKED_OFFSET(first+rows)-PACKED_OFFSET(first), 1));
+    if(P==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    return P;
+}
+/*
+ * Name: initializePacked
+ * Generates the packed rows first..first+rows-1 of a symmetric matrix: the rows are generated dense by
+ * initializeMatrix, SPARSE_CHUNK at a time, and only the elements (i, 0..i) are kept.
+ *
+ * Input:
+ *      P (float*) - The packed rows, allocated by createPacked
+ *      test (Test) - The test of the values
+ *      first (int) - The first row
+ *      rows (int) - The number of rows
+ *      N (int) - The side of the matrix
+ *
+ * Output: none
+ */
+void initializePacked(float* P, Test test, int first, int rows, int N) {
+    const int chunk=MIN(SPARSE_CHUNK, MAX(rows, 1));
+    float** dense=NULL;
+    int start, i;
+    create2DFloatMatrix(&dense, chunk, N);
+    for (start=0; start<rows; start+=chunk) {
+        const int x=MIN(chunk, rows-start);
+        initializeMatrix(dense, test, first+start, x, N, N);
+        for (i=0; i<x; i++) {
+            const int r=first+start+i;
+            memcpy(&P[PACKED_OFFSET(r)-PACKED_OFFSET(first)], dense[i], sizeof(float)*(r+1));
+        }
+    }
+    free2DMemory(&dense);
+}
+/*
+ * Name: packedElement
+ * Reads the element (i, j) of a symmetric matrix from its packed rows, at (max, min) in the lower triangle.
+ *
+ * Input:
+ *      P (const float*) - The packed rows, the row max(i, j) has to be one of them
+ *      first (int) - The first row of P
+ *      i (int) - The row of the element
+ *      j (int) - The column of the element
+ *
+ * Output:
+ *      float - The element
+ */
+float packedElement(const float* P, int first, int i, int j) {
+    const int high=MAX(i, j), low=MIN(i, j);
+    return P[PACKED_OFFSET(high)-PACKED_OFFSET(first)+low];
+}
+/*
+ * Name: transposePacked
+ * Transposition of a symmetric matrix stored packed: the packed lower triangle of the transposed matrix is the same,
+ * so it's given back as an alias, without copying nor moving anything.
+ *
+ * Input:
+ *      P (const float*) - The packed rows of the matrix
+ *
+ * Output:
+ *      const float* - The packed rows of the transposed matrix (P itself)
+ */
+const float* transposePacked(const float* P) {
+    return P;
+}
+/*
+ * Name: writePacked
+ * Appends in FILENAMEPACKED the times of a configuration run with the symmetric matrix stored packed, kept apart
+ * from the times, the averages and the statistics of the mode because the transposition is only an alias.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - The dimension of the matrix
+ *      test (const int) - The test type used for matrix generation
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      stats (const Statistics*) - The statistics of the samples
+ *      bytes (long long) - The bytes of the packed matrix
+ *
+ * Output: none
+ */
+void writePacked(const char* code, const int mode, const int n, const int test, const int num_procs, const int scaling, const Statistics* stats, long long bytes) {
+    FILE* file=fopen(FILENAMEPACKED, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMEPACKED);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-15s\n", "Compile", "Mode", "Dimension", "Test_Mode", "N Procs", "Scaling", "Samples", "Median(s)", "P95(s)", "Bytes");
+    }
+    fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-15lld\n", code, mode, n, test, num_procs, scaling, stats->samples, stats->median, stats->p95, bytes);
+    fclose(file);
+}
+/*
+ * Name: compressFloats
+ * Lossless codec for the blocks exchanged between processes. Each float is XORed with the previous one, so
+ * close values (same sign and exponent) leave the high bytes to zero, then the bytes are shuffled in 4 planes
+ * (all the first bytes, then all the second ones...) to put these zeros next to each other and finally the
+ * planes are encoded with a run length: a token with the high bit set is a run of (token&0x7F)+1 zeros, otherwise
+ * it's followed by token+1 literal bytes. The output is at most count*4+count*4/128+1 bytes.
+ *
+ * Input:
+ *      in (const float*) - The floats to compress
+ *      count (int) - The number of floats
+ *      out (unsigned char*) - Destination of the compressed bytes (at least count*4+count*4/128+1 bytes)
+ *
+ * Output:
+ *      int - The number of compressed bytes written in out
+ */
+int compressFloats(const float* in, int count, unsigned char* out) {
+    int n=count*(int)sizeof(float);
+    unsigned char* planes=malloc(n>0 ? n : 1);
+    if(planes==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    uint32_t previous=0, current;
+    int i, k;
+    for (i=0; i<count; i++) {
+        memcpy(&current, &in[i], sizeof(uint32_t));
+        uint32_t delta=current^previous;
+        previous=current;
+        for (k=0; k<4; k++) {
+            planes[k*count+i]=(unsigned char)(delta>>(8*k));
+        }
+    }
+    int o=0;
+    i=0;
+    while (i<n) {
+        if(planes[i]==0 && i+1<n && planes[i+1]==0) {
+            int run=2;
+            while (i+run<n && planes[i+run]==0 && run<128) {
+                run++;
+            }
+            out[o++]=(unsigned char)(0x80|(run-1));
+            i+=run;
+        }
+        else {
+            int start=i, length=0;
+            while (i<n && length<128 && !(length>0 && planes[i]==0 && i+1<n && planes[i+1]==0)) {
+                i++;
+                length++;
+            }
+            out[o++]=(unsigned char)(length-1);
+            memcpy(&out[o], &planes[start], length);
+            o+=length;
+        }
+    }
+    free(planes);
+    return o;
+}
+/*
+ * Name: decompressFloats
+ * Inverse of compressFloats: expands the runs in the byte planes, puts the bytes of each float together
+ * and undoes the XOR with the previous float.
+ *
+ * Input:
+ *      in (const unsigned char*) - The compressed bytes
+ *      bytes (int) - The number of compressed bytes
+ *      out (float*) - Destination of the floats
+ *      count (int) - The number of floats to obtain
+ *
+ * Output: none
+ */
+void decompressFloats(const unsigned char* in, int bytes, float* out, int count) {
+    int n=count*(int)sizeof(float);
+    unsigned char* planes=malloc(n>0 ? n : 1);
+    if(planes==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    int i=0, o=0, k;
+    while (i<bytes && o<n) {
+        int token=in[i++];
+        int length=(token&0x7F)+1;
+        length=MIN(length, n-o);
+        if(token&0x80) {
+            memset(&planes[o], 0, length);
+        }
+        else {
+            memcpy(&planes[o], &in[i], length);
+            i+=length;
+        }
+        o+=length;
+    }
+    uint32_t previous=0;
+    for (i=0; i<count; i++) {
+        uint32_t delta=0;
+        for (k=0; k<4; k++) {
+            delta|=((uint32_t)planes[k*count+i])<<(8*k);
+        }
+        previous^=delta;
+        memcpy(&out[i], &previous, sizeof(uint32_t));
+    }
+    free(planes);
+}
+/*
+ * Name: exchangeFloats
+ * Sends count floats to dest and receives count floats from source with a single MPI_Sendrecv, like the
+ * exchange of the blocks among the processes. If the wire compression is enabled (--compress) and the message
+ * has at least the threshold of bytes, the block is compressed before the exchange and decompressed on receive.
+ * The first byte of a compressed message says if the codec was applied, because when it doesn't reduce the size
+ * the raw floats are sent. The sizes, the time of the codec and of the exchange are added to compression_stats.
+ *
+ * Input:
+ *      sendbuf (float*) - The floats to send
+ *      dest (int) - The rank receiving sendbuf
+ *      recvbuf (float*) - Destination of the received floats
+ *      source (int) - The rank sending recvbuf
+ *      count (int) - The number of floats sent and received
+ *      tag (int) - Tag of the messages
+ *
+ * Output: none
+ */
+void exchangeFloats(float* sendbuf, int dest, float* recvbuf, int source, int count, int tag) {
+    long long raw=(long long)count*sizeof(float);
+    if(options.compress<0 || raw<options.compress) {
+        MPI_Sendrecv(sendbuf, count, MPI_FLOAT, dest, tag, recvbuf, count, MPI_FLOAT, source, tag, actual_comm, MPI_STATUS_IGNORE);
+        return;
+    }
+    int bound=1+(int)raw+(int)raw/128+1;
+    unsigned char* wire_send=malloc(bound);
+    unsigned char* wire_recv=malloc(bound);
+    if(wire_send==NULL || wire_recv==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    double t0=MPI_Wtime();
+    int bytes=compressFloats(sendbuf, count, wire_send+1);
+    if(bytes>=raw) {
+        wire_send[0]=0;
+        memcpy(wire_send+1, sendbuf, raw);
+        bytes=(int)raw;
+    }
+    else {
+        wire_send[0]=1;
+    }
+    double t1=MPI_Wtime();
+    MPI_Status status;
+    MPI_Sendrecv(wire_send, bytes+1, MPI_BYTE, dest, tag, wire_recv, bound, MPI_BYTE, source, tag, actual_comm, &status);
+    double t2=MPI_Wtime();
+    int received;
+    MPI_Get_count(&status, MPI_BYTE, &received);
+    if(wire_recv[0]==1) {
+        decompressFloats(wire_recv+1, received-1, recvbuf, count);
+    }
+    else {
+        memcpy(recvbuf, wire_recv+1, raw);
+    }
+    double t3=MPI_Wtime();
+    compression_stats.messages++;
+    compression_stats.raw_bytes+=raw;
+    compression_stats.wire_bytes+=bytes+1;
+    compression_stats.codec_time+=(t1-t0)+(t3-t2);
+    compression_stats.exchange_time+=(t2-t1);
+    free(wire_send);
+    free(wire_recv);
+}
+/*
+ * Name: reportCompression
+ * Sums the statistics of the wire compression of all the processes on rank 0, which prints them and appends them
+ * on the file FILENAMECOMPRESSION. The time saved is estimated as the bytes not sent over the bandwidth measured
+ * in the exchanges, minus the time spent in the codec. It has to be called by all the processes.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - Dimension Size
+ *      num_procs (const int) - The number of processes
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void reportCompression(const char* code, const int mode, const int n, const int num_procs, int rank) {
+    if(options.compress<0) {
+        return;
+    }
+    long long local_counts[3]={compression_stats.messages, compression_stats.raw_bytes, compression_stats.wire_bytes};
+    double local_times[2]={compression_stats.codec_time, compression_stats.exchange_time};
+    long long counts[3];
+    double times[2];
+    MPI_Reduce(local_counts, counts, 3, MPI_LONG_LONG, MPI_SUM, 0, actual_comm);
+    MPI_Reduce(local_times, times, 2, MPI_DOUBLE, MPI_SUM, 0, actual_comm);
+    if(rank!=0) {
+        return;
+    }
+    double ratio=(counts[2]>0) ? (double)counts[1]/counts[2] : 1.0;
+    //Bandwidth seen by the compressed messages, used to estimate the time of the bytes not sent
+    double bandwidth=(times[1]>0.0) ? counts[2]/times[1] : 0.0;
+    double saved=(bandwidth>0.0) ? (counts[1]-counts[2])/bandwidth-times[0] : 0.0;
+    printf("Compression (threshold %lld bytes): %lld messages, %lld raw bytes, %lld wire bytes, ratio %.3f, codec %.6lf s, exchange %.6lf s, estimated saved %.6lf s\n", options.compress, counts[0], counts[1], counts[2], ratio, times[0], times[1], saved);
+    FILE* file=fopen(FILENAMECOMPRESSION, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMECOMPRESSION);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-12s %-12s %-15s %-15s %-10s %-15s %-15s %-15s\n", "Compile", "Mode", "Dimension", "N Procs", "Threshold", "Messages", "Raw_bytes", "Wire_bytes", "Ratio", "Codec(s)", "Exchange(s)", "Saved(s)");
+    }
+    fprintf(file, "%-15s %-5d %-10d %-10d %-12lld %-12lld %-15lld %-15lld %-10.3lf %-15.12lf %-15.12lf %-15.12lf\n", code, mode, n, num_procs, options.compress, counts[0], counts[1], counts[2], ratio, times[0], times[1], saved);
+    fclose(file);
+}
+/*
+ * Name: startProgress
+ * Starts the progress engine of the non-blocking transfers. With --progress=1 and an MPI library initialized with
+ * MPI_THREAD_MULTIPLE, a thread (progressLoop) tests the outstanding requests while the main thread computes, so
+ * that the transfers advance also when the library doesn't progress them by itself outside the MPI calls (as
+ * MPICH over TCP or shared memory). Otherwise the requests are completed by the waits of the main thread.
+ *
+ * Input:
+ *      provided (int) - The level of thread support given by MPI_Init_thread
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void startProgress(int provided, int rank) {
+    if(!options.progress) {
+        return;
+    }
+    if(provided<MPI_THREAD_MULTIPLE) {
+        if(rank==0) {
+            printf("The MPI library doesn't provide MPI_THREAD_MULTIPLE, the transfers progress only in the MPI calls\n");
+        }
+        options.progress=0;
+        return;
+    }
+    pthread_mutex_init(&progress.lock, NULL);
+    pthread_cond_init(&progress.posted, NULL);
+    pthread_cond_init(&progress.completed, NULL);
+    progress.stop=0;
+    if(pthread_create(&progress.thread, NULL, progressLoop, NULL)!=0) {
+        if(rank==0) {
+            printf("The progress thread couldn't be started, the transfers progress only in the MPI calls\n");
+        }
+        options.progress=0;
+        return;
+    }
+    progress.running=1;
+}
+/*
+ * Name: progressLoop
+ * Body of the progress thread: while there are pending requests it completes them with MPI_Testsome, marking
+ * them and waking up the main thread, and yields the processor between two tests (the main thread may share it);
+ * without pending requests it sleeps until one is added or stopProgress is called.
+ *
+ * Input:
+ *      arg (void*) - Unused
+ *
+ * Output: void* - NULL
+ */
+void* progressLoop(void* arg) {
+    int outcount, k;
+    (void)arg;
+    pthread_mutex_lock(&progress.lock);
+    while (!progress.stop) {
+        if(progress.pending==0) {
+            pthread_cond_wait(&progress.posted, &progress.lock);
+            continue;
+        }
+        MPI_Testsome(progress.count, progress.requests, &outcount, progress.indices, MPI_STATUSES_IGNORE);
+        if(outcount!=MPI_UNDEFINED && outcount>0) {
+            for (k=0; k<outcount; k++) {
+                progress.state[progress.indices[k]]=1;
+            }
+            progress.pending-=outcount;
+            progress.last=MPI_Wtime();
+            pthread_cond_broadcast(&progress.completed);
+        }
+        pthread_mutex_unlock(&progress.lock);
+        sched_yield();
+        pthread_mutex_lock(&progress.lock);
+    }
+    pthread_mutex_unlock(&progress.lock);
+    return NULL;
+}
+/*
+ * Name: progressAdd
+ * Adds a request to the ones of the current exchange, given to the progress thread if it's running. The
+ * requests of an exchange are numbered in order from 0 until progressWaitAll.
+ *
+ * Input:
+ *      request (MPI_Request) - The request of a non-blocking transfer just posted
+ *
+ * Output: int - The number of the request
+ */
+int progressAdd(MPI_Request request) {
+    if(progress.running) {
+        pthread_mutex_lock(&progress.lock);
+    }
+    if(progress.count==progress.capacity) {
+        progress.capacity=MAX(2*progress.capacity, 64);
+        progress.requests=(MPI_Request*)realloc(progress.requests, sizeof(MPI_Request)*progress.capacity);
+        progress.indices=(int*)realloc(progress.indices, sizeof(int)*progress.capacity);
+        progress.state=(int*)realloc(progress.state, sizeof(int)*progress.capacity);
+        if(progress.requests==NULL || progress.indices==NULL || progress.state==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+    }
+    const int index=progress.count++;
+    progress.requests[index]=request;
+    progress.state[index]=0;
+    progress.pending++;
+    if(progress.running) {
+        pthread_cond_signal(&progress.posted);
+        pthread_mutex_unlock(&progress.lock);
+    }
+    return index;
+}
+/*
+ * Name: progressWaitAny
+ * Waits until one of the requests first..first+count-1 not returned yet is completed, and returns it. It has to be
+ * called at most count times for the same requests.
+ *
+ * Input:
+ *      first (int) - The number of the first request
+ *      count (int) - The number of requests
+ *
+ * Output: int - The number of the completed request
+ */
+int progressWaitAny(int first, int count) {
+    int index=MPI_UNDEFINED, k;
+    if(!progress.running) {
+        MPI_Waitany(count, &progress.requests[first], &index, MPI_STATUS_IGNORE);
+        progress.state[first+index]=2;
+        progress.pending--;
+        progress.last=MPI_Wtime();
+        return first+index;
+    }
+    pthread_mutex_lock(&progress.lock);
+    while (index==MPI_UNDEFINED) {
+        for (k=first; k<first+count && progress.state[k]!=1; k++);
+        if(k<first+count) {
+            progress.state[k]=2;
+            index=k;
+        }
+        else {
+            pthread_cond_wait(&progress.completed, &progress.lock);
+        }
+    }
+    pthread_mutex_unlock(&progress.lock);
+    return index;
+}
+/*
+ * Name: progressWaitAll
+ * Waits until all the requests of the current exchange are completed, then the next request added is again the
+ * number 0.
+ *
+ * Input: none
+ * Output: double - The time when the last request was completed
+ */
+double progressWaitAll(void) {
+    double last;
+    if(!progress.running) {
+        if(progress.pending>0) {
+            MPI_Waitall(progress.count, progress.requests, MPI_STATUSES_IGNORE);
+            progress.last=MPI_Wtime();
+        }
+        progress.pending=0;
+        progress.count=0;
+        return progress.last;
+    }
+    pthread_mutex_lock(&progress.lock);
+    while (progress.pending>0) {
+        pthread_cond_wait(&progress.completed, &progress.lock);
+    }
+    progress.count=0;
+    last=progress.last;
+    pthread_mutex_unlock(&progress.lock);
+    return last;
+}
+/*
+ * Name: stopProgress
+ * Stops and joins the progress thread, if running, and frees the requests. It has to be called before
+ * MPI_Finalize.
+ *
+ * Input: none
+ * Output: none
+ */
+void stopProgress(void) {
+    if(progress.running) {
+        pthread_mutex_lock(&progress.lock);
+        progress.stop=1;
+        pthread_cond_signal(&progress.posted);
+        pthread_mutex_unlock(&progress.lock);
+        pthread_join(progress.thread, NULL);
+        pthread_mutex_destroy(&progress.lock);
+        pthread_cond_destroy(&progress.posted);
+        pthread_cond_destroy(&progress.completed);
+        progress.running=0;
+    }
+    free(progress.requests);
+    free(progress.indices);
+    free(progress.state);
+    progress.requests=NULL;
+    progress.indices=NULL;
+    progress.state=NULL;
+    progress.count=0;
+    progress.capacity=0;
+}
+/*
+ * Name: reportOverlap
+ * Sums the times of the overlapped exchanges of all the processes on rank 0, which prints per exchange the time of
+ * the communication, the part hidden behind the local transposition and the part exposed (waited by the main
+ * thread), with the efficiency of the overlap (hidden over communication), and appends them on the file
+ * FILENAMEOVERLAP. Nothing is reported if no overlapped exchange was done. It has to be called by all the
+ * processes.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - Dimension Size
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void reportOverlap(const char* code, const int mode, const int n, const int num_procs, const int scaling, int rank) {
+    double local[3]={(double)overlap_stats.exchanges, overlap_stats.communication, overlap_stats.exposed};
+    double sum[3];
+    MPI_Reduce(local, sum, 3, MPI_DOUBLE, MPI_SUM, 0, actual_comm);
+    if(rank!=0 || sum[0]==0.0) {
+        return;
+    }
+    const double communication=sum[1]/sum[0];
+    const double exposed=sum[2]/sum[0];
+    const double hidden=communication-exposed;
+    const double efficiency=(communication>0.0) ? hidden/communication*100 : 0.0;
+    printf("Overlap (progress thread %s): communication %.9lf s, hidden %.9lf s, exposed %.9lf s per exchange, efficiency %.2lf%%\n", options.progress ? "on" : "off", communication, hidden, exposed, efficiency);
+    FILE* file=fopen(FILENAMEOVERLAP, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMEOVERLAP);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-15s %-15s %-15s %-10s\n", "Compile", "Mode", "Dimension", "N Procs", "Scaling", "Progress", "Comm(s)", "Hidden(s)", "Exposed(s)", "Overlap(%)");
+    }
+    fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-15.12lf %-10.2lf\n", code, mode, n, num_procs, scaling, options.progress, communication, hidden, exposed, efficiency);
+    fclose(file);
+}
+
+/*
+ * Name: reportPhases
+ * Reduces on rank 0 the minimum, the average and the maximum among the processes of the time per sample spent in
+ * each phase, which prints them with the imbalance (maximum over average) and appends them on the file
+ * FILENAMEPHASES, a line per phase. The phases never entered by the mode are skipped. It has to be called by all
+ * the processes.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - Dimension Size
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      samples (const int) - The number of samples measured
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void reportPhases(const char* code, const int mode, const int n, const int num_procs, const int scaling, const int samples, int rank) {
+    if(!options.phases) {
+        return;
+    }
+    const char* names[PHASES]={"bcast", "scatter", "checksym", "transpose", "exchange", "gather"};
+    double local[PHASES], minimum[PHASES], maximum[PHASES], sum[PHASES];
+    int i, procs;
+    MPI_Comm_size(actual_comm, &procs);
+    for (i=0; i<PHASES; i++) {
+        local[i]=phase_times.total[i]/samples;
+    }
+    MPI_Reduce(local, minimum, PHASES, MPI_DOUBLE, MPI_MIN, 0, actual_comm);
+    MPI_Reduce(local, maximum, PHASES, MPI_DOUBLE, MPI_MAX, 0, actual_comm);
+    MPI_Reduce(local, sum, PHASES, MPI_DOUBLE, MPI_SUM, 0, actual_comm);
+    if(rank!=0) {
+        return;
+    }
+    FILE* file=fopen(FILENAMEPHASES, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMEPHASES);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-15s %-10s\n", "Compile", "Mode", "Dimension", "N Procs", "Scaling", "Samples", "Phase", "Min(s)", "Avg(s)", "Max(s)", "Imbalance");
+    }
+    printf("%-10s %-15s %-15s %-15s %-10s\n", "Phase", "Min(s)", "Avg(s)", "Max(s)", "Imbalance");
+    for (i=0; i<PHASES; i++) {
+        if(maximum[i]<=0.0) {
+            continue;
+        }
+        const double average=sum[i]/procs;
+        printf("%-10s %-15.9lf %-15.9lf %-15.9lf %-10.2lf\n", names[i], minimum[i], average, maximum[i], maximum[i]/average);
+        fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-10s %-15.12lf %-15.12lf %-15.12lf %-10.2lf\n", code, mode, n, num_procs, scaling, samples, names[i], minimum[i], average, maximum[i], maximum[i]/average);
+    }
+    fclose(file);
+}
+/*
+ * Name: setupCounters
+ * Opens with perf_event_open the hardware counters of the process (cycles, instructions, misses of the last level
+ * cache, read misses of the L1 data cache and of the data TLB), counting only the user space of the calling
+ * thread. The counters run from here to freeCounters and are read at the begin and at the end of the local
+ * kernels. The events not supported by the machine (or forbidden by perf_event_paranoid) are left unavailable
+ * and reported as -1. Outside Linux no event is available.
+ *
+ * Input: none
+ * Output: none
+ */
+void setupCounters(void) {
+    int i;
+    for (i=0; i<EVENTS; i++) {
+        counters.fd[i]=-1;
+    }
+    memset(counters.total, 0, sizeof(counters.total));
+    if(!options.counters) {
+        return;
+    }
+#ifdef __linux__
+    const unsigned int types[EVENTS]={PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+    const unsigned long long configs[EVENTS]={
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_CACHE_L1D|(PERF_COUNT_HW_CACHE_OP_READ<<8)|(PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+        PERF_COUNT_HW_CACHE_DTLB|(PERF_COUNT_HW_CACHE_OP_READ<<8)|(PERF_COUNT_HW_CACHE_RESULT_MISS<<16)
+    };
+    for (i=0; i<EVENTS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size=sizeof(attr);
+        attr.type=types[i];
+        attr.config=configs[i];
+        attr.exclude_kernel=1;
+        attr.exclude_hv=1;
+        counters.fd[i]=(int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+/*
+ * Name: readCounters
+ * Reads the current value of the hardware counters of the process (0 for the events not available).
+ *
+ * Input:
+ *      values (long long[EVENTS]) - The values read
+ *
+ * Output: none
+ */
+void readCounters(long long values[EVENTS]) {
+    int i;
+    for (i=0; i<EVENTS; i++) {
+        values[i]=0;
+        if(counters.fd[i]>=0 && read(counters.fd[i], &values[i], sizeof(long long))!=sizeof(long long)) {
+            values[i]=0;
+        }
+    }
+}
+/*
+ * Name: accumulateCounters
+ * Adds to the totals of a phase the events counted since the last readCounters in counters.start.
+ *
+ * Input:
+ *      phase (Phase) - The phase that is ending
+ *
+ * Output: none
+ */
+void accumulateCounters(Phase phase) {
+    long long values[EVENTS];
+    int i;
+    readCounters(values);
+    for (i=0; i<EVENTS; i++) {
+        counters.total[phase][i]+=values[i]-counters.start[i];
+    }
+}
+/*
+ * Name: reportCounters
+ * Sums on rank 0 the hardware counters of the local kernels (checksym and transpose) of all the processes, which
+ * prints them per sample with the instructions per cycle and appends them on the file FILENAMECOUNTERS, a line per
+ * kernel. An event is reported as -1 if it isn't available on every process. It has to be called by all the
+ * processes.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - Dimension Size
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      samples (const int) - The number of samples measured
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void reportCounters(const char* code, const int mode, const int n, const int num_procs, const int scaling, const int samples, int rank) {
+    if(!options.counters) {
+        return;
+    }
+    const Phase kernels[2]={PHASE_CHECK, PHASE_TRANSPOSE};
+    const char* names[2]={"checksym", "transpose"};
+    long long local[2][EVENTS], sum[2][EVENTS];
+    int available[EVENTS], everywhere[EVENTS];
+    int i, k;
+    for (i=0; i<EVENTS; i++) {
+        available[i]=(counters.fd[i]>=0) ? 1 : 0;
+        for (k=0; k<2; k++) {
+            local[k][i]=counters.total[kernels[k]][i];
+        }
+    }
+    MPI_Reduce(local, sum, 2*EVENTS, MPI_LONG_LONG, MPI_SUM, 0, actual_comm);
+    MPI_Reduce(available, everywhere, EVENTS, MPI_INT, MPI_MIN, 0, actual_comm);
+    if(rank!=0) {
+        return;
+    }
+    FILE* file=fopen(FILENAMECOUNTERS, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMECOUNTERS);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-8s %-15s %-15s %-15s\n", "Compile", "Mode", "Dimension", "N Procs", "Scaling", "Samples", "Kernel", "Cycles", "Instructions", "IPC", "LLC_misses", "L1D_misses", "DTLB_misses");
+    }
+    printf("%-10s %-15s %-15s %-8s %-15s %-15s %-15s\n", "Kernel", "Cycles", "Instructions", "IPC", "LLC_misses", "L1D_misses", "DTLB_misses");
+    for (k=0; k<2; k++) {
+        long long per_sample[EVENTS];
+        for (i=0; i<EVENTS; i++) {
+            per_sample[i]=everywhere[i] ? sum[k][i]/samples : -1;
+        }
+        const double ipc=(per_sample[EVENT_CYCLES]>0 && per_sample[EVENT_INSTRUCTIONS]>=0) ? (double)per_sample[EVENT_INSTRUCTIONS]/per_sample[EVENT_CYCLES] : -1.0;
+        printf("%-10s %-15lld %-15lld %-8.2lf %-15lld %-15lld %-15lld\n", names[k], per_sample[EVENT_CYCLES], per_sample[EVENT_INSTRUCTIONS], ipc, per_sample[EVENT_LLC_MISSES], per_sample[EVENT_L1D_MISSES], per_sample[EVENT_DTLB_MISSES]);
+        fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-10s %-15lld %-15lld %-8.2lf %-15lld %-15lld %-15lld\n", code, mode, n, num_procs, scaling, samples, names[k], per_sample[EVENT_CYCLES], per_sample[EVENT_INSTRUCTIONS], ipc, per_sample[EVENT_LLC_MISSES], per_sample[EVENT_L1D_MISSES], per_sample[EVENT_DTLB_MISSES]);
+    }
+    fclose(file);
+}
+/*
+ * Name: freeCounters
+ * Closes the hardware counters opened by setupCounters.
+ *
+ * Input: none
+ * Output: none
+ */
+void freeCounters(void) {
+    int i;
+    for (i=0; i<EVENTS; i++) {
+        if(counters.fd[i]>=0) {
+            close(counters.fd[i]);
+            counters.fd[i]=-1;
+        }
+    }
+}
+/*
+ * Name: measureBaseline
+ * Measures the limits of the hardware that the transpositions are compared with, using the same allocator
+ * (create2DFloatMatrix) and the same processes of actual_comm:
+ *  1. STREAM copy: every process copies at the same time an array of max(N*C, 4*L3/processes of the node) floats, so it
+ *     doesn't fit in cache, STREAM_REPEATS times after a barrier; the time of a repetition is the slowest process
+ *     and the bandwidth, counting read and write as STREAM does, is the one of the best repetition;
+ *  2. MPI ping-pong between rank 0 and the last rank: the latency is half of the round trip of a float and the
+ *     bandwidth the one of a message of N*C floats.
+ * Rank 0 prints the results and appends them on the file FILENAMEBASELINE, where reportBandwidth finds them.
+ * It has to be called by all the processes.
+ *
+ * Input:
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *      rank (int) - The rank of the current process
+ *
+ * Output: none
+ */
+void measureBaseline(int N, int C, int rank) {
+    int num_procs, i, k;
+    float** A=NULL;
+    float** B=NULL;
+    MPI_Comm_size(actual_comm, &num_procs);
+    const int nodes=countNodes(actual_comm);
+    const int count=(int)MAX((long long)N*C, 4LL*cache.l3/(long long)sizeof(float)/cache.node_procs);
+    //1. STREAM copy
+    create2DFloatMatrix(&A, 1, count);
+    create2DFloatMatrix(&B, 1, count);
+    for (i=0; i<count; i++) {
+        A[0][i]=1.0f;
+        B[0][i]=0.0f;
+    }
+    double best=0.0;
+    for (k=0; k<STREAM_REPEATS; k++) {
+        double elapsed, slowest=0.0;
+        MPI_Barrier(actual_comm);
+        const double start=MPI_Wtime();
+        for (i=0; i<count; i++) {
+            B[0][i]=A[0][i];
+        }
+        elapsed=MPI_Wtime()-start;
+        MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, actual_comm);
+        if(k==0 || slowest<best) {
+            best=slowest;
+        }
+    }
+    const double copy=2.0*count*sizeof(float)*num_procs/best/1e9;
+    free2DMemory(&A);
+    free2DMemory(&B);
+    //2. MPI ping-pong between the first and the last rank
+    double latency=0.0, pingpong=0.0;
+    const int message=N*C;
+    if(num_procs>1) {
+        const int partner=(rank==0) ? num_procs-1 : 0;
+        const int sizes[2]={1, message};
+        const int repeats[2]={PINGPONG_REPEATS, MAX(PINGPONG_REPEATS/10, 1)};
+        double round_trip[2]={0.0, 0.0};
+        float* buffer=malloc(sizeof(float)*message);
+        if(buffer==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        memset(buffer, 0, sizeof(float)*message);
+        for (k=0; k<2; k++) {
+            MPI_Barrier(actual_comm);
+            if(rank==0 || rank==num_procs-1) {
+                //The first round trip opens the connection and is not measured
+                for (i=-1; i<repeats[k]; i++) {
+                    const double start=MPI_Wtime();
+                    if(rank==0) {
+                        MPI_Send(buffer, sizes[k], MPI_FLOAT, partner, k, actual_comm);
+                        MPI_Recv(buffer, sizes[k], MPI_FLOAT, partner, k, actual_comm, MPI_STATUS_IGNORE);
+                    }
+                    else {
+                        MPI_Recv(buffer, sizes[k], MPI_FLOAT, partner, k, actual_comm, MPI_STATUS_IGNORE);
+                        MPI_Send(buffer, sizes[k], MPI_FLOAT, partner, k, actual_comm);
+                    }
+                    if(i>=0) {
+                        round_trip[k]+=MPI_Wtime()-start;
+                    }
+                }
+                round_trip[k]/=repeats[k];
+            }
+        }
+        free(buffer);
+        latency=round_trip[0]/2;
+        pingpong=(double)message*sizeof(float)/(round_trip[1]/2)/1e9;
+    }
+    if(rank!=0) {
+        return;
+    }
+    printf("Baseline on %d processes and %d nodes:\nSTREAM copy: %.3lf GB/s (%d floats per process)\n", num_procs, nodes, copy, count);
+    if(num_procs>1) {
+        printf("Ping-pong rank 0 <-> rank %d: latency %.3lf us, bandwidth %.3lf GB/s (%d floats)\n", num_procs-1, latency*1e6, pingpong, message);
+    }
+    FILE* file=fopen(FILENAMEBASELINE, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMEBASELINE);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-10s %-10s %-15s %-15s %-15s %-15s\n", "N Procs", "Nodes", "Copy(GB/s)", "Latency(us)", "PingPong(GB/s)", "Message(B)");
+    }
+    fprintf(file, "%-10d %-10d %-15.3lf %-15.3lf %-15.3lf %-15lld\n", num_procs, nodes, copy, latency*1e6, pingpong, (long long)message*(long long)sizeof(float));
+    fclose(file);
+}
+/*
+ * Name: lookupBaseline
+ * Searches in the file FILENAMEBASELINE the last STREAM copy bandwidth measured with a number of processes.
+ *
+ * Input:
+ *      num_procs (int) - The number of processes
+ *      copy (double*) - The bandwidth of the STREAM copy in GB/s
+ *
+ * Output:
+ *      bool - True if a baseline with num_procs processes was found
+ */
+bool lookupBaseline(int num_procs, double* copy) {
+    char line[256];
+    int fprocs, fnodes;
+    long long fmessage;
+    double fcopy, flatency, fpingpong;
+    bool found=false;
+    FILE* file=fopen(FILENAMEBASELINE, "r");
+    if(file==NULL) {
+        return false;
+    }
+    //An empty file (no header) has no baselines
+    if(fgets(line, sizeof(line), file)!=NULL) {
+        while(fscanf(file, "%d %d %lf %lf %lf %lld", &fprocs, &fnodes, &fcopy, &flatency, &fpingpong, &fmessage)==6) {
+            if(fprocs==num_procs) {
+                *copy=fcopy;
+                found=true;
+            }
+        }
+    }
+    fclose(file);
+    return found;
+}
+/*
+ * Name: reportBandwidth
+ * Prints the effective bandwidth of a transposition, the bytes of the matrix read and written (like a STREAM
+ * copy) over the median time, and the percentage of the STREAM copy bandwidth measured by mode MPI_BASELINE with
+ * the same number of processes, appending them on the file FILENAMEBANDWIDTH. Called only by rank 0.
+ *
+ * Input:
+ *      code (const char*) - The code or label to be recorded in the file
+ *      mode (const int) - The execution mode
+ *      n (const int) - Dimension Size
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      bytes (const double) - The bytes moved by a transposition (2*rows*columns*sizeof(float))
+ *      time (const double) - The median time of a transposition
+ *
+ * Output: none
+ */
+void reportBandwidth(const char* code, const int mode, const int n, const int num_procs, const int scaling, const double bytes, const double time) {
+    double peak=0.0;
+    const double effective=bytes/time/1e9;
+    const bool found=lookupBaseline(num_procs, &peak);
+    if(found) {
+        printf("Effective bandwidth: %.3lf GB/s, %.2lf%% of the STREAM copy of %.3lf GB/s\n", effective, effective/peak*100, peak);
+    }
+    else {
+        printf("Effective bandwidth: %.3lf GB/s (no baseline with %d processes, run mode %d)\n", effective, num_procs, MPI_BASELINE);
+    }
+    FILE* file=fopen(FILENAMEBANDWIDTH, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMEBANDWIDTH);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-15s %-15s %-15s %-10s\n", "Compile", "Mode", "Dimension", "N Procs", "Scaling", "Time(s)", "GB/s", "Peak(GB/s)", "Peak%");
+    }
+    if(found) {
+        fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-15.12lf %-15.3lf %-15.3lf %-10.2lf%%\n", code, mode, n, num_procs, scaling, time, effective, peak, effective/peak*100);
+    }
+    else {
+        fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-15.12lf %-15.3lf %-15c %-10c%%\n", code, mode, n, num_procs, scaling, time, effective, '-', '-');
+    }
+    fclose(file);
+}
+/*
+ * Name: PrintMatrix
+ * Prints out on stdout all the Matrix indexed. This was used for control to verify that the program worked for small matrices. It's not present in the running code
+ *   Input:
+ *      M (float**) - The start allocated in heap matrix
+ *      size(int) - Dimension of the matrix
+ * Output: none
+ */
+void printMatrix(float** M, int x, int y) {
+    int i, j;
+    for (i=0; i<x; i++) {
+        for(j=0; j<y; j++) {
+            printf("%.2f\t", M[i][j]);
+        }
+        printf("\n");
+    }
+}
+/*
+ * Name: matrixCheckPerRank
+ * Prints the matrix data that has been assigned to the current MPI rank for debugging purposes.
+ * This function is useful to verify the data distribution across processes.
+ *
+ * Input:
+ *      M (float**) - The matrix to be printed. This is the local portion of the matrix assigned to the current rank.
+ *      rank (int) - The rank of the current MPI process.
+ *      x (int) - The number of rows assigned to the current process.
+ *      y (int) - The number of columns assigned to the current process.
+ *
+ * Output: none
+ */
+
+void matrixCheckPerRank(float** M, int rank, int x, int y) {
+    int i, j;
+    printf("Rank %d scatter\n\n", rank);
+    for (i=0; i<x; i++) {
+        for (j=0; j<y; j++) {
+            printf("Rank: %d %d %d - %.2f\n", rank, i+1, j+1, M[i*x+j]);
+        }
+        printf("\n");
+    }
+}
+/*
+ * Name: control
+ * Another control algorithm for verifying that the transposition happened correctly. Happened a transposition of
+ *   Input:
+ *      M (float**) - The start allocated in heap matrix (x rows and y columns)
+ *      T (float**) - The destination allocated in heap matrix (y rows and x columns)
+ *      x (int) - Rows of the start matrix
+ *      y (int) - Columns of the start matrix
+ * Output: none
+ */
+void control(float** M, float** T, int x, int y) {
+    int i[3]={MIN(1, x-1), MAX(x/2-4, 0), MAX(x-5, 0)};
+    int j[3]={MIN(2, y-1), MIN(y/2+2, y-1), MAX(y-3, 0)};
+    int k;
+    for (k=0; k<3; k++) {
+        printf("[%d][%d] M: %.2f T: %.2f\n", i[k], j[k], M[i[k]][j[k]], T[j[k]][i[k]]);
+    }
+}
+/*
+ * Name: controlDistributed
+ * Control of the transposition of mode MPI_DISTRIBUTED, where rank 0 has only its slabs: the block of its rows
+ * and of its columns of the start matrix is also in its slab of the transposed one, so some elements of it are
+ * printed as control does.
+ *   Input:
+ *      M (float**) - The slab of the start matrix of rank 0 (rows x C)
+ *      T (float**) - The slab of the transposed matrix of rank 0 (cols x N)
+ *      rows (int) - Rows of the slab of the start matrix
+ *      cols (int) - Rows of the slab of the transposed matrix
+ * Output: none
+ */
+void controlDistributed(float** M, float** T, int rows, int cols) {
+    int i[3]={MIN(1, rows-1), rows/2, MAX(rows-1, 0)};
+    int j[3]={0, cols/2, MAX(cols-1, 0)};
+    int k;
+    for (k=0; k<3; k++) {
+        printf("[%d][%d] M: %.2f T: %.2f\n", i[k], j[k], M[i[k]][j[k]], T[j[k]][i[k]]);
+    }
+}
+/*
+ * Name: controlSparse
+ * Control of the transposition of mode MPI_SPARSE on rank 0: prints up to 3 nonzeros of its slab whose column is
+ * one of its rows of the transposed matrix, with the element found in the transposed slab at the symmetric position.
+ * Input:
+ *      A (const Sparse*) - The slab of the start matrix of rank 0
+ *      T (const Sparse*) - The slab of the transposed matrix of rank 0
+ * Output: none
+ */
+void controlSparse(const Sparse* A, const Sparse* T) {
+    int i, k, l, printed=0;
+    for (i=0; i<A->rows && printed<3; i++) {
+        for (k=A->row_ptr[i]; k<A->row_ptr[i+1] && printed<3; k++) {
+            const int c=A->col_idx[k]-T->first;
+            if(c<0 || c>=T->rows) {
+                continue;
+            }
+            float value=0.0f;
+            for (l=T->row_ptr[c]; l<T->row_ptr[c+1]; l++) {
+                if(T->col_idx[l]==A->first+i) {
+                    value=T->values[l];
+                }
+            }
+            printf("[%d][%d] M: %.2f T: %.2f\n", A->first+i, A->col_idx[k], A->values[k], value);
+            printed++;
+        }
+    }
+}
+/*
+ *  Name: readCpuList
+ *  Function that reads a list of processors (or of NUMA nodes) from a sysfs file, in the format 0-3,8,10-11.
+ *  Input:
+ *      path (const char*) - The file
+ *      list (int*) - The ids read, in increasing order
+ *      max (int) - The maximum ids stored
+ *  Output: int - The number of ids read (0 if the file doesn't exist)
+ */
+int readCpuList(const char* path, int* list, int max) {
+    char text[4096];
+    char* cursor=text;
+    char* end;
+    int count=0;
+    FILE* file=fopen(path, "r");
+    if(file==NULL) {
+        return 0;
+    }
+    if(fgets(text, sizeof(text), file)==NULL) {
+        text[0]='\0';
+    }
+    fclose(file);
+    while(*cursor!='\0' && *cursor!='\n') {
+        long first=strtol(cursor, &end, 10);
+        long last=first;
+        if(end==cursor) {
+            break;
+        }
+        if(*end=='-') {
+            cursor=end+1;
+            last=strtol(cursor, &end, 10);
+        }
+        for (; first<=last && count<max; first++) {
+            list[count++]=(int)first;
+        }
+        cursor=(*end==',') ? end+1 : end;
+    }
+    return count;
+}
+/*
+ *  Name: readSysfsInt
+ *  Function that reads an integer from a sysfs file.
+ *  Input:
+ *      path (const char*) - The file
+ *      fallback (int) - The value returned if the file can't be read
+ *  Output: int - The value read
+ */
+int readSysfsInt(const char* path, int fallback) {
+    int value=fallback;
+    FILE* file=fopen(path, "r");
+    if(file!=NULL) {
+        if(fscanf(file, "%d", &value)!=1) {
+            value=fallback;
+        }
+        fclose(file);
+    }
+    return value;
+}
+/*
+ *  Name: compareCpus
+ *  Compares two processors for qsort in the compact order: socket, NUMA node, last level cache and id.
+ *  Input:
+ *      a, b (const void*) - Pointers to the ids of the processors
+ *  Output: int - Negative, zero or positive if a comes before, together or after b
+ */
+int compareCpus(const void* a, const void* b) {
+    const int x=*(const int*)a;
+    const int y=*(const int*)b;
+    if(topology.socket[x]!=topology.socket[y]) {
+        return topology.socket[x]-topology.socket[y];
+    }
+    if(topology.numa[x]!=topology.numa[y]) {
+        return topology.numa[x]-topology.numa[y];
+    }
+    if(topology.llc[x]!=topology.llc[y]) {
+        return topology.llc[x]-topology.llc[y];
+    }
+    return x-y;
+}
+/*
+ *  Name: partnerOrder
+ *  Function that lists the positions of a grid of processes so that the owners of a block and of its transposed
+ *  position are next to each other: the permutation (i, j) -> (j, i) of the block modes (the destination of the
+ *  rank i*dims[1]+j is j*dims[0]+i) is split in its cycles, pairs in a square grid, and they are listed one after the
+ *  other, first the ones with more positions and then the diagonal ones, which fill the gaps between the sockets.
+ *  Input:
+ *      dims (const int[2]) - The grid of processes (rows and columns), as created by createPlan
+ *      order (int*) - The dims[0]*dims[1] positions in the order of the cycles
+ *  Output: none
+ */
+void partnerOrder(const int dims[2], int* order) {
+    const int num_procs=dims[0]*dims[1];
+    bool* visited=(bool*)calloc(num_procs, sizeof(bool));
+    int r, pass, k=0;
+    if(visited==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    for (pass=0; pass<2; pass++) {
+        for (r=0; r<num_procs; r++) {
+            const bool diagonal=((r%dims[1])*dims[0]+r/dims[1]==r);
+            int position=r;
+            if(diagonal!=(pass==1)) {
+                continue;
+            }
+            while(!visited[position]) {
+                visited[position]=true;
+                order[k++]=position;
+                position=(position%dims[1])*dims[0]+position/dims[1];
+            }
+        }
+    }
+    free(visited);
+}
+/*
+ *  Name: pinProcess
+ *  Function that pins the process, and its OpenMP threads one per processor, to a slot of the processors in compact
+ *  order: the processors of the node are split in equal consecutive slots among its processes (one processor each,
+ *  round robin, if they are more than the processors). The slot of the position is the same with AFFINITY_COMPACT
+ *  and AFFINITY_PARTNER, while AFFINITY_SCATTER takes the slots round robin on the NUMA nodes.
+ *  Input:
+ *      position (int) - The position of the process among the ones of its node
+ *      leader (int) - The lowest rank of the node, to tell the sockets of different nodes apart
+ *  Output: none
+ */
+void pinProcess(int position, int leader) {
+    if(topology.cpus==0) {
+        return;
+    }
+    topology.count=MAX(topology.cpus/topology.node_size, 1);
+    const int slots=topology.cpus/topology.count;
+    int slot=position%slots;
+    if(options.affinity==AFFINITY_SCATTER) {
+        const int groups=MIN(topology.numa_nodes, slots);
+        slot=(slot%groups)*(slots/groups)+(slot/groups)%(slots/groups);
+    }
+    topology.first=slot*topology.count;
+#ifdef __linux__
+    cpu_set_t set;
+    int k;
+    CPU_ZERO(&set);
+    for (k=0; k<topology.count; k++) {
+        CPU_SET(topology.cpu[topology.first+k], &set);
+    }
+    if(sched_setaffinity(0, sizeof(set), &set)!=0) {
+        printf("Pinning failed: %s\n", strerror(errno));
+        return;
+    }
+#ifdef _OPENMP
+#pragma omp parallel
+    {
+        cpu_set_t thread_set;
+        CPU_ZERO(&thread_set);
+        CPU_SET(topology.cpu[topology.first+omp_get_thread_num()%topology.count], &thread_set);
+        sched_setaffinity(0, sizeof(thread_set), &thread_set);
+    }
+#endif
+    topology.domain=leader*MAX_CPUS+topology.socket[topology.cpu[topology.first]];
+#else
+    (void)leader;
+    printf("Pinning not supported on this system\n");
+#endif
+}
+/*
+ *  Name: setupTopology
+ *  Function that reads the topology of the node from sysfs (processors given to the job, socket, NUMA node and last
+ *  level cache of each one) and, with --affinity, pins the processes according to the policy:
+ *      AFFINITY_COMPACT - The processes of the node in rank order on consecutive processors, filling a socket first
+ *      AFFINITY_SCATTER - The processes in rank order round robin on the NUMA nodes, consecutive in each one
+ *      AFFINITY_PARTNER - As compact, but in the order of partnerOrder, so the owners of a block and of its
+ *                         transposed position of the block modes are next to each other
+ *  The pinning stops the migrations between the samples and lets createPlan put the partners on the same socket.
+ *  It has to be called by all the processes of comm.
+ *  Input:
+ *      comm (MPI_Comm) - Communicator of the processes of the benchmark
+ *  Output: none
+ */
+void setupTopology(MPI_Comm comm) {
+    char path[256];
+    int list[MAX_CPUS];
+    unsigned long mask[MAX_CPUS/(8*sizeof(unsigned long))], node_mask[MAX_CPUS/(8*sizeof(unsigned long))];
+    const int bits=8*sizeof(unsigned long), words=MAX_CPUS/bits;
+    int rank, num_procs, leader, position, i, k, n, index, level, llc_level=0;
+    bool seen[MAX_CPUS];
+    MPI_Comm node_comm;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &topology.node_rank);
+    MPI_Comm_size(node_comm, &topology.node_size);
+    MPI_Allreduce(&rank, &leader, 1, MPI_INT, MPI_MIN, node_comm);
+    //Processors given to the job on the node, the launcher may have bound each process to a part of them
+    memset(mask, 0, sizeof(mask));
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set)==0) {
+        for (i=0; i<MAX_CPUS && i<CPU_SETSIZE; i++) {
+            if(CPU_ISSET(i, &set)) {
+                mask[i/bits]|=1UL<<(i%bits);
+            }
+        }
+    }
+#endif
+    MPI_Allreduce(mask, node_mask, words, MPI_UNSIGNED_LONG, MPI_BOR, node_comm);
+    topology.cpus=0;
+    topology.domain=-1;
+    topology.first=0;
+    topology.count=0;
+    for (i=0; i<MAX_CPUS; i++) {
+        snprintf(path, sizeof(path), "%s/cpu%d/topology/physical_package_id", SYSFSCPU, i);
+        topology.socket[i]=MAX(readSysfsInt(path, 0), 0);
+        topology.numa[i]=0;
+        topology.llc[i]=i;
+        if(node_mask[i/bits]&(1UL<<(i%bits))) {
+            topology.cpu[topology.cpus++]=i;
+        }
+    }
+    //NUMA nodes of the processors
+    n=readCpuList(SYSFSNODE "/possible", list, MAX_CPUS);
+    int nodes[MAX_CPUS];
+    memcpy(nodes, list, sizeof(int)*n);
+    for (k=0; k<n; k++) {
+        snprintf(path, sizeof(path), "%s/node%d/cpulist", SYSFSNODE, nodes[k]);
+        const int count=readCpuList(path, list, MAX_CPUS);
+        for (i=0; i<count; i++) {
+            topology.numa[list[i]]=nodes[k];
+        }
+    }
+    //Last level cache of each processor, identified by the lowest processor sharing it
+    for (index=0; ; index++) {
+        snprintf(path, sizeof(path), "%s/cpu0/cache/index%d/level", SYSFSCPU, index);
+        if((level=readSysfsInt(path, -1))<0) {
+            break;
+        }
+        llc_level=MAX(llc_level, level);
+    }
+    for (k=0; k<topology.cpus; k++) {
+        for (index=0; ; index++) {
+            snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/level", SYSFSCPU, topology.cpu[k], index);
+            if((level=readSysfsInt(path, -1))<0) {
+                break;
+            }
+            snprintf(path, sizeof(path), "%s/cpu%d/cache/index%d/shared_cpu_list", SYSFSCPU, topology.cpu[k], index);
+            if(level==llc_level && readCpuList(path, list, MAX_CPUS)>0) {
+                topology.llc[topology.cpu[k]]=list[0];
+                break;
+            }
+        }
+    }
+    topology.sockets=topology.numa_nodes=topology.llcs=0;
+    memset(seen, 0, sizeof(seen));
+    for (k=0; k<topology.cpus; k++) {
+        const int socket=topology.socket[topology.cpu[k]]%MAX_CPUS;
+        topology.sockets+=seen[socket] ? 0 : 1;
+        seen[socket]=true;
+    }
+    memset(seen, 0, sizeof(seen));
+    for (k=0; k<topology.cpus; k++) {
+        topology.numa_nodes+=seen[topology.numa[topology.cpu[k]]] ? 0 : 1;
+        seen[topology.numa[topology.cpu[k]]]=true;
+    }
+    memset(seen, 0, sizeof(seen));
+    for (k=0; k<topology.cpus; k++) {
+        topology.llcs+=seen[topology.llc[topology.cpu[k]]] ? 0 : 1;
+        seen[topology.llc[topology.cpu[k]]]=true;
+    }
+    //Processors in compact order
+    qsort(topology.cpu, topology.cpus, sizeof(int), compareCpus);
+    position=topology.node_rank;
+    if(options.affinity==AFFINITY_PARTNER) {
+        //Position of the rank in the order of the cycles of the grid createPlan would build on comm
+        int dims[2]={0, 0};
+        int* order=(int*)malloc(sizeof(int)*num_procs);
+        MPI_Comm ordered;
+        if(order==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        MPI_Dims_create(num_procs, 2, dims);
+        partnerOrder(dims, order);
+        for (k=0; k<num_procs && order[k]!=rank; k++);
+        MPI_Comm_split(node_comm, 0, k, &ordered);
+        MPI_Comm_rank(ordered, &position);
+        MPI_Comm_free(&ordered);
+        free(order);
+    }
+    MPI_Comm_free(&node_comm);
+    if(rank==0) {
+        printf("Topology of the node: %d processors, %d sockets, %d NUMA nodes, %d last level caches - Affinity %s\n", topology.cpus, topology.sockets, topology.numa_nodes, topology.llcs, affinityName(options.affinity));
+    }
+    if(options.affinity!=AFFINITY_NONE) {
+        pinProcess(position, leader);
+        if(topology.count>0) {
+            const int cpu=topology.cpu[topology.first];
+            printf("Rank %d pinned to %d processors from %d (socket %d, NUMA node %d, position %d of %d on the node)\n", rank, topology.count, cpu, topology.socket[cpu], topology.numa[cpu], position, topology.node_size);
+        }
+    }
+}
+/*
+ *  Name: reorderPartners
+ *  Function that orders the processes of comm for the Cartesian grid of the block modes so that the owners of a
+ *  block and of its transposed position share a socket where possible: the cycles of partnerOrder, longest first,
+ *  are put each one in the socket with more free processes (split only if no socket has room for the whole cycle).
+ *  Rank 0 keeps the position 0, as the root of the scatter and of the gather. Rank 0 prints the partners on the same socket before and after. The processes have to be pinned.
+ *  Input:
+ *      comm (MPI_Comm) - The communicator of the grid
+ *      dims (const int[2]) - The grid of processes
+ *      reordered (MPI_Comm*) - The communicator with the ranks of the new positions, to free
+ *  Output: none
+ */
+void reorderPartners(MPI_Comm comm, const int dims[2], MPI_Comm* reordered) {
+    int rank, num_procs, k, c, d, before=0, after=0, groups=0, cycles=0, position=0;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+    int* domains=(int*)malloc(sizeof(int)*num_procs);
+    int* order=(int*)malloc(sizeof(int)*num_procs);
+    int* owner=(int*)malloc(sizeof(int)*num_procs);
+    int* group_start=(int*)malloc(sizeof(int)*(num_procs+1));
+    int* group_used=(int*)calloc(num_procs, sizeof(int));
+    int* cycle_start=(int*)malloc(sizeof(int)*(num_procs+1));
+    long long* keys=(long long*)malloc(sizeof(long long)*num_procs);
+    long long* cycle_keys=(long long*)malloc(sizeof(long long)*num_procs);
+    if(domains==NULL || order==NULL || owner==NULL || group_start==NULL || group_used==NULL || cycle_start==NULL || keys==NULL || cycle_keys==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    MPI_Allgather(&topology.domain, 1, MPI_INT, domains, 1, MPI_INT, comm);
+    //Processes grouped by socket
+    for (k=0; k<num_procs; k++) {
+        keys[k]=(long long)domains[k]*num_procs+k;
+    }
+    qsort(keys, num_procs, sizeof(long long), compareLongLongs);
+    for (k=0; k<num_procs; k++) {
+        if(k==0 || keys[k]/num_procs!=keys[k-1]/num_procs) {
+            group_start[groups++]=k;
+        }
+    }
+    group_start[groups]=num_procs;
+    //Cycles of the permutation, sorted by decreasing length
+    partnerOrder(dims, order);
+    for (k=0; k<num_procs; k++) {
+        //A cycle ends when the destination of its last position is the first one
+        const int first=order[cycles>0 ? cycle_start[cycles-1] : 0];
+        if(k==0 || (order[k-1]%dims[1])*dims[0]+order[k-1]/dims[1]==first) {
+            cycle_start[cycles++]=k;
+        }
+    }
+    cycle_start[cycles]=num_procs;
+    for (c=0; c<cycles; c++) {
+        cycle_keys[c]=(long long)(num_procs-(cycle_start[c+1]-cycle_start[c]))*num_procs+c;
+    }
+    qsort(cycle_keys, cycles, sizeof(long long), compareLongLongs);
+    //The block (0, 0) stays in place: it is kept by rank 0, that has the matrices, first of its socket
+    for (d=0; d<groups; d++) {
+        if(keys[group_start[d]]%num_procs==0) {
+            group_used[d]=1;
+        }
+    }
+    owner[0]=0;
+    for (c=0; c<cycles; c++) {
+        const int cycle=(int)(cycle_keys[c]%num_procs);
+        int best=0;
+        if(order[cycle_start[cycle]]==0) {
+            continue;
+        }
+        for (k=cycle_start[cycle]; k<cycle_start[cycle+1]; k++) {
+            //The socket with more free processes, kept for the whole cycle while it has room
+            if(k==cycle_start[cycle] || group_used[best]==group_start[best+1]-group_start[best]) {
+                for (d=0; d<groups; d++) {
+                    if(group_start[d+1]-group_start[d]-group_used[d]>group_start[best+1]-group_start[best]-group_used[best]) {
+                        best=d;
+                    }
+                }
+            }
+            owner[order[k]]=(int)(keys[group_start[best]+group_used[best]++]%num_procs);
+            if(owner[order[k]]==rank) {
+                position=order[k];
+            }
+        }
+    }
+    for (k=0; k<num_procs; k++) {
+        const int dest=(k%dims[1])*dims[0]+k/dims[1];
+        before+=(domains[k]==domains[dest]) ? 1 : 0;
+        after+=(domains[owner[k]]==domains[owner[dest]]) ? 1 : 0;
+    }
+    if(rank==0) {
+        printf("Cartesian reorder: %d of %d blocks with the transposed position on the same socket (%d in rank order)\n", after, num_procs, before);
+    }
+    MPI_Comm_split(comm, 0, position, reordered);
+    free(domains);
+    free(order);
+    free(owner);
+    free(group_start);
+    free(group_used);
+    free(cycle_start);
+    free(keys);
+    free(cycle_keys);
+}
+/*
+ *  Name: affinityName
+ *  Function that gives the name of a policy of placement, as in --affinity.
+ *  Input:
+ *      affinity (Affinity) - The policy
+ *  Output: const char* - Its name
+ */
+const char* affinityName(Affinity affinity) {
+    const char* names[4]={"none", "compact", "scatter", "partner"};
+    return names[affinity];
+}
+/*
+ *  Name: setupCache
+ *  Function that reads the caches of the node from sysfs (level, type and size of each index of the first cpu, the default
+ *  CACHESIZE* if they aren't available) and allocates once the buffer written by flushCache to evict them. The
+ *  last level cache is shared by the processes of the node, so each one covers only its part of it: together they
+ *  write about twice the caches of the node, instead of the whole last level cache each one as before.
+ *  It has to be called by all the processes of comm.
+ *  Input:
+ *      comm (MPI_Comm) - Communicator of the processes of the benchmark
+ *  Output: none
+ */
+void setupCache(MPI_Comm comm) {
+    char path[256], type[32];
+    int index, level;
+    long long size;
+    char unit;
+    cache.l1d=CACHESIZEL1D;
+    cache.l1i=CACHESIZEL1I;
+    cache.l2=CACHESIZEL2;
+    cache.l3=CACHESIZEL3;
+    cache.detected=0;
+    cache.buffer=NULL;
+    cache.count=0;
+    cache.sweeps=0;
+    for (index=0; ; index++) {
+        FILE* file;
+        snprintf(path, sizeof(path), "%s/index%d/level", SYSFSCACHE, index);
+        if((file=fopen(path, "r"))==NULL) {
+            break;
+        }
+        level=0;
+        if(fscanf(file, "%d", &level)!=1) {
+            level=0;
+        }
+        fclose(file);
+        snprintf(path, sizeof(path), "%s/index%d/type", SYSFSCACHE, index);
+        if((file=fopen(path, "r"))==NULL || fscanf(file, "%31s", type)!=1) {
+            strcpy(type, "Unified");
+        }
+        if(file!=NULL) {
+            fclose(file);
+        }
+        snprintf(path, sizeof(path), "%s/index%d/size", SYSFSCACHE, index);
+        if((file=fopen(path, "r"))==NULL) {
+            continue;
+        }
+        unit='B';
+        if(fscanf(file, "%lld%c", &size, &unit)<1) {
+            size=0;
+        }
+        fclose(file);
+        size*=(unit=='K') ? KB : (unit=='M') ? KB*KB : (unit=='G') ? (long long)KB*KB*KB : 1;
+        if(size<=0) {
+            continue;
+        }
+        if(level==1 && strcmp(type, "Instruction")==0) {
+            cache.l1i=size;
+        }
+        else if(level==1) {
+            cache.l1d=size;
+        }
+        else if(level==2) {
+            cache.l2=size;
+        }
+        else if(level>=3) {
+            cache.l3=size;
+        }
+        else {
+            continue;
+        }
+        cache.detected=1;
+    }
+    //Processes sharing the last level cache (and the memory bandwidth) of the node
+    int rank;
+    MPI_Comm node_comm;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_size(node_comm, &cache.node_procs);
+    MPI_Comm_free(&node_comm);
+    if(options.cache==CACHE_WARM) {
+        return;
+    }
+    cache.count=2*(cache.l1d+cache.l2+cache.l3/cache.node_procs)/(long long)sizeof(float);
+    if(posix_memalign((void**)&cache.buffer, CACHELINE, cache.count*sizeof(float))!=0) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    memset(cache.buffer, 0, cache.count*sizeof(float));
+}
+/*
+ *  Name: flushCache
+ *  Function that prepares the state of the caches before a sample according to options.cache:
+ *      CACHE_COLD - Writes the persistent flush buffer of setupCache (a different value at each sweep), evicting
+ *                   every line of the matrices
+ *      CACHE_CLFLUSH - Evicts with clflush only the lines of the given buffers, without touching the rest of the
+ *                      memory (x86 only, the flush buffer is written on the other architectures)
+ *      CACHE_WARM - Nothing, the matrices stay in the caches after their initialization
+ *  Input:
+ *      buffers (const void* const[]) - Buffers of the sample, of any type (NULL ones are skipped)
+ *      sizes (const long long[]) - Bytes of each buffer
+ *      n (int) - Number of buffers
+ *  Output: none
+ */
+void flushCache(const void* const buffers[], const long long sizes[], int n) {
+    long long i;
+    int k;
+    if(options.cache==CACHE_WARM) {
+        return;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    if(options.cache==CACHE_CLFLUSH) {
+        for (k=0; k<n; k++) {
+            const char* bytes=(const char*)buffers[k];
+            if(bytes==NULL || sizes[k]<=0) {
+                continue;
+            }
+            for (i=0; i<sizes[k]; i+=CACHELINE) {
+                _mm_clflush(bytes+i);
+            }
+            _mm_clflush(bytes+sizes[k]-1);
+        }
+        _mm_mfence();
+        return;
+    }
+#else
+    (void)buffers;
+    (void)sizes;
+    (void)n;
+    (void)k;
+#endif
+    const float value=(float)(++cache.sweeps);
+    for (i=0; i<cache.count; i++) {
+        cache.buffer[i]=value;
+    }
+}
+/*
+ *  Name: freeCache
+ *  Function that frees the flush buffer allocated by setupCache.
+ *  Input: none
+ *  Output: none
+ */
+void freeCache(void) {
+    free(cache.buffer);
+    cache.buffer=NULL;
+    cache.count=0;
+}
+/*
+ *  Name: getSequential
+ *  Function that retrieves the sequential execution time for a given dimension and test from the index of the
+ *  sequential times, loaded once from the file of the sequential results and updated by the rows of this run.
+ *  Input:
+ *      dim (int) - Dimension for which we are retrieving the sequential time
+ *      cols (int) - Columns of the matrix, so the rectangular runs aren't compared with the square ones
+ *      test (int) - Test identifier to filter the relevant entry
+ *      scaling (int) - Scaling mode defining 0. Strong 1. Weak
+ *  Output:
+ *      double - Returns the average time for the sequential execution. If not found in the file, it returns 0.00
+ */
+double getSequential(const int dim, const int cols, const char* code, const int mode, const int test, const int scaling) {
+    if(results_store.sequential==NULL) {
+        loadSequential();
+    }
+    const SequentialEntry* entry=findSequential(code, mode, dim, cols, test, scaling);
+    return entry->used ? entry->time : 0.00;
+}
+/*
+ *  Name: hashSequential
+ *  Function that hashes (FNV-1a) the key of a sequential time.
+ *  Input:
+ *      code (const char*) - The code identifier, truncated as in the index
+ *      mode, dim, cols, test, scaling (const int) - The rest of the key
+ *  Output:
+ *      unsigned long long - The hash of the key
+ */
+unsigned long long hashSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling) {
+    const int fields[5]={mode, dim, cols, test, scaling};
+    unsigned long long hash=1469598103934665603ULL;
+    int i;
+    for (; *code!='\0'; code++) {
+        hash=(hash^(unsigned char)*code)*1099511628211ULL;
+    }
+    for (i=0; i<5; i++) {
+        hash=(hash^(unsigned int)fields[i])*1099511628211ULL;
+    }
+    return hash;
+}
+/*
+ *  Name: findSequential
+ *  Function that finds the slot of a key in the index of the sequential times with linear probing.
+ *  Input:
+ *      code (const char*) - The code identifier
+ *      mode, dim, cols, test, scaling (const int) - The rest of the key
+ *  Output:
+ *      SequentialEntry* - The slot of the key, or the empty one where it would be inserted (used is false)
+ */
+SequentialEntry* findSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling) {
+    char key[20];
+    snprintf(key, sizeof(key), "%s", code);
+    const int mask=results_store.sequential_slots-1;
+    int slot=(int)(hashSequential(key, mode, dim, cols, test, scaling)&(unsigned long long)mask);
+    SequentialEntry* entry=&results_store.sequential[slot];
+    while(entry->used && !(entry->mode==mode && entry->dim==dim && entry->cols==cols && entry->test==test && entry->scaling==scaling && strcmp(entry->code, key)==0)) {
+        slot=(slot+1)&mask;
+        entry=&results_store.sequential[slot];
+    }
+    return entry;
+}
+/*
+ *  Name: indexSequential
+ *  Function that inserts a sequential time in the index if its key isn't already there (the first row of a key
+ *  in the file wins, as the old scan did), doubling the table when it is half full.
+ *  Input:
+ *      code (const char*) - The code identifier
+ *      mode, dim, cols, test, scaling (const int) - The rest of the key
+ *      time (const double) - The sequential time
+ *  Output: none
+ */
+void indexSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling, const double time) {
+    int i;
+    if(2*(results_store.sequential_count+1)>results_store.sequential_slots) {
+        SequentialEntry* old=results_store.sequential;
+        const int old_slots=results_store.sequential_slots;
+        results_store.sequential_slots*=2;
+        results_store.sequential=(SequentialEntry*)calloc(results_store.sequential_slots, sizeof(SequentialEntry));
+        if(results_store.sequential==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        for (i=0; i<old_slots; i++) {
+            if(old[i].used) {
+                *findSequential(old[i].code, old[i].mode, old[i].dim, old[i].cols, old[i].test, old[i].scaling)=old[i];
+            }
+        }
+        free(old);
+    }
+    SequentialEntry* entry=findSequential(code, mode, dim, cols, test, scaling);
+    if(entry->used) {
+        return;
+    }
+    snprintf(entry->code, sizeof(entry->code), "%s", code);
+    entry->mode=mode;
+    entry->dim=dim;
+    entry->cols=cols;
+    entry->test=test;
+    entry->scaling=scaling;
+    entry->time=time;
+    entry->used=true;
+    results_store.sequential_count++;
+}
+/*
+ *  Name: loadSequential
+ *  Function that builds the index of the sequential times reading once the file of the sequential results, with a
+ *  shared lock against the runs flushing on it at the same time. The files written before the Columns field have
+ *  only square matrices, their columns are the dimension.
+ *  Input: none
+ *  Output: none
+ */
+void loadSequential(void) {
+    char line[256];
+    int findex, fmode, fdimension, fcolumns, ftest, fsamples, fprocs, fscaling;
+    char fcompile[20];
+    double favg_time;
+    results_store.sequential_slots=SEQUENTIAL_SLOTS;
+    results_store.sequential_count=0;
+    results_store.sequential=(SequentialEntry*)calloc(results_store.sequential_slots, sizeof(SequentialEntry));
+    if(results_store.sequential==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    FILE* file=fopen(FILENAMESEQ, "r");
+    if(file==NULL) {
+        return;
+    }
+    flock(fileno(file), LOCK_SH);
+    if(fgets(line, sizeof(line), file)!=NULL) {
+        const bool columns=(strstr(line, "Columns")!=NULL);
+        while(fgets(line, sizeof(line), file)!=NULL) {
+            if(columns && sscanf(line, "%d %19s %d %d %d %d %d %d %d %lf", &findex, fcompile, &fmode, &fdimension, &fcolumns, &ftest, &fsamples, &fprocs, &fscaling, &favg_time)==10) {
+                indexSequential(fcompile, fmode, fdimension, fcolumns, ftest, fscaling, favg_time);
+            }
+            else if(!columns && sscanf(line, "%d %19s %d %d %d %d %d %d %lf", &findex, fcompile, &fmode, &fdimension, &ftest, &fsamples, &fprocs, &fscaling, &favg_time)==9) {
+                indexSequential(fcompile, fmode, fdimension, fdimension, ftest, fscaling, favg_time);
+            }
+        }
+    }
+    flock(fileno(file), LOCK_UN);
+    fclose(file);
+}
+/*
+ *  Name: openFile
+ *  Function that adds a row of performance data of a file to the results store. Depending on the mode and type, it computes speedup and efficiency from the index of the sequential times. The rows are written on the files, with their header if they are empty, only by flushResults at the end of the run.
+ *  Input:
+ *      filename (const char*) - The name of the file to open.
  *      code (const char*) - The code or label to be recorded in the file
  *      mode (int) - The mode of the computation (SO0 for sequential - see readMe for others)
  *      dim (int) - Dimension Size
+ *      cols (int) - The number of columns
  *      test (int) - The test case identifier
  *      samples (int) - The number of samples
  *      num_procs (int) - The number of threads used
@@ -705,249 +3578,1901 @@ double getSequential(const int dim, const char* code, const int mode, const int
  *      type (int) - Determines the type of output file (0 - times, 1- average)
  *  Output: none
  */
-void openFile(const char* filename, const char* code, const int mode, const int dim, const int test, const int samples, const int num_procs, const int scaling, double avg_time, int type) {
-    FILE* file=fopen(filename, "a+"); //read and append
-    if(file==NULL) {
-        fprintf(stderr, "Couldn't open or create %s\n", filename);
-        exit(1);
+void openFile(const char* filename, const char* code, const int mode, const int dim, const int cols, const int test, const int samples, const int num_procs, const int scaling, double avg_time, int type) {
+    double seq_time = 0.0;
+    double speedup=0.0;
+    double efficiency=0.0;
+    if(num_procs!=1 && type==1) {
+        seq_time=getSequential(dim, cols, code, mode, test, scaling);
+        speedup=seq_time/avg_time;
+        if(scaling==0) {
+            efficiency=speedup/num_procs*100;
+        }
+        else {
+            efficiency=speedup*100;
+        }
+    }
+    else {
+        seq_time=avg_time;
+        speedup=seq_time/avg_time;
+        if(scaling==0) {
+            efficiency=speedup/num_procs*100;
+        }
+        else {
+            efficiency=speedup*100;
+        }
+    }
+    if(type==1 && strcmp(filename, FILENAMESEQ)==0) {
+        if(results_store.sequential==NULL) {
+            loadSequential();
+        }
+        indexSequential(code, mode, dim, cols, test, scaling, avg_time);
+    }
+    if(results_store.count==results_store.capacity) {
+        results_store.capacity=(results_store.capacity==0) ? RESULTS_ROWS : 2*results_store.capacity;
+        ResultRow* rows=(ResultRow*)realloc(results_store.rows, sizeof(ResultRow)*results_store.capacity);
+        if(rows==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        results_store.rows=rows;
+    }
+    ResultRow* row=&results_store.rows[results_store.count++];
+    row->filename=filename;
+    row->type=type;
+    snprintf(row->code, sizeof(row->code), "%s", code);
+    row->mode=mode;
+    row->dim=dim;
+    row->cols=cols;
+    row->test=test;
+    row->samples=samples;
+    row->num_procs=num_procs;
+    row->scaling=scaling;
+    row->time=avg_time;
+    row->seq_time=seq_time;
+    row->speedup=speedup;
+    row->efficiency=efficiency;
+}
+/*
+ *  Name: countLines
+ *  Function that counts the lines of a file reading it in chunks, from the start.
+ *  Input:
+ *      file (FILE*) - The file, opened for reading
+ *  Output:
+ *      int - The number of lines
+ */
+int countLines(FILE* file) {
+    char chunk[65536];
+    size_t read, i;
+    int lines=0;
+    rewind(file);
+    while((read=fread(chunk, 1, sizeof(chunk), file))>0) {
+        for (i=0; i<read; i++) {
+            lines+=(chunk[i]=='\n');
+        }
+    }
+    return lines;
+}
+/*
+ *  Name: writeResultRow
+ *  Function that writes a row of the results store on its file, with the header if the file is empty.
+ *  Input:
+ *      file (FILE*) - The file of the row, opened for appending
+ *      row (const ResultRow*) - The row
+ *      index (int) - The number of the row (N°)
+ *  Output: none
+ */
+void writeResultRow(FILE* file, const ResultRow* row, int index) {
+    fseek(file, 0, SEEK_END);
+    long long file_size=ftell(file);
+    if(file_size==0 && row->type==1) {
+        fprintf(file, "%-10s %-15s %-5s %-10s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-10s %-10s\n", "N°", "Compile", "Mode", "Dimension", "Columns", "Test_Mode", "Samples", "N Procs", "Scaling", "Avg_Time(s)", "Seq_time(s)", "Speedup", "Efficiency");
+    }
+    else {
+        if(file_size==0 && row->type==0) {
+            //The rows of the times have always had the scaling before the processes
+            fprintf(file, "%-10s %-15s %-5s %-10s %-10s %-10s %-10s %-10s %-10s %-15s\n", "N°", "Compile", "Mode", "Dimension", "Columns", "Test_Mode", "Samples", "Scaling", "N Procs", "Time(s)");
+        }
+    }
+    char void_element='-';
+    if(row->type==0) {
+        fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12lf\n", index, row->code, row->mode, row->dim, row->cols, row->test, row->samples, row->scaling, row->num_procs, row->time);
+    }
+    else {
+        if(row->seq_time<1e-9) {
+            fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12f %-15c %-10c %-10c%%\n", index, row->code, row->mode, row->dim, row->cols, row->test, row->samples, row->num_procs, row->scaling, row->time, void_element, void_element, void_element);
+        }
+        else {
+            fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-10.2lf %-10.2lf%%\n", index, row->code, row->mode, row->dim, row->cols, row->test, row->samples, row->num_procs, row->scaling, row->time, row->seq_time, row->speedup, row->efficiency);
+        }
+    }
+}
+/*
+ *  Name: flushResults
+ *  Function that writes on the files the rows of the results store and empties it. For each type the general file
+ *  (timesGeneral.csv or resultsGeneral.csv) is locked exclusively for the whole flush, so the runs writing at the
+ *  same time don't mix their rows, and the rows are numbered (N°) from its lines as they were at the time of the
+ *  writing: the lines of the general file, counted once instead of with a wc -l per row.
+ *  Input: none
+ *  Output: none
+ */
+void flushResults(void) {
+    const char* generals[2]={FILENAMETGEN, FILENAMEGEN};
+    int type, i, k;
+    if(results_store.count==0) {
+        free(results_store.sequential);
+        memset(&results_store, 0, sizeof(ResultsStore));
+        return;
+    }
+    int* index=(int*)malloc(sizeof(int)*results_store.count);
+    if(index==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    for (type=0; type<2; type++) {
+        FILE* general=fopen(generals[type], "a+");
+        if(general==NULL) {
+            fprintf(stderr, "Couldn't open or create %s\n", generals[type]);
+            exit(1);
+        }
+        flock(fileno(general), LOCK_EX);
+        int lines=countLines(general);
+        for (i=0; i<results_store.count; i++) {
+            if(results_store.rows[i].type!=type) {
+                continue;
+            }
+            index[i]=MAX(lines, 1);
+            if(strcmp(results_store.rows[i].filename, generals[type])==0) {
+                writeResultRow(general, &results_store.rows[i], index[i]);
+                lines=(lines==0) ? 2 : lines+1;
+            }
+        }
+        fflush(general);
+        //The other files of the type, each one once
+        for (i=0; i<results_store.count; i++) {
+            const char* filename=results_store.rows[i].filename;
+            if(results_store.rows[i].type!=type || strcmp(filename, generals[type])==0) {
+                continue;
+            }
+            for (k=0; k<i && !(results_store.rows[k].type==type && strcmp(results_store.rows[k].filename, filename)==0); k++);
+            if(k<i) {
+                continue;
+            }
+            FILE* file=fopen(filename, "a+");
+            if(file==NULL) {
+                fprintf(stderr, "Couldn't open or create %s\n", filename);
+                exit(1);
+            }
+            flock(fileno(file), LOCK_EX);
+            for (k=i; k<results_store.count; k++) {
+                if(results_store.rows[k].type==type && strcmp(results_store.rows[k].filename, filename)==0) {
+                    writeResultRow(file, &results_store.rows[k], index[k]);
+                }
+            }
+            fflush(file);
+            flock(fileno(file), LOCK_UN);
+            fclose(file);
+        }
+        flock(fileno(general), LOCK_UN);
+        fclose(general);
+    }
+    free(index);
+    free(results_store.rows);
+    free(results_store.sequential);
+    memset(&results_store, 0, sizeof(ResultsStore));
+}
+/*
+ *  Name: inputParameters
+ *  Function that checks the number of arguments passed to the program (7 ok, less exits or more).
+ *  Input:
+ *      argc (int) - The number of arguments passed to the program.
+ *  Output: none
+ */
+void inputParameters(int argc) {
+    printf("%d\n\n\n", argc);
+    if(argc<7) {
+        fprintf(stderr, "Invalid parameters. They are:\n\n(1) Code identifying the compilation (everything is acceptable, default one is SO0, is used as reference for sequential code -O0 and will be used as comparison for speedup and efficiency)\n\n(2)Integer for mode. The modes are:\n1. Sequential Code\n2. MPI Parallelism All Gather\n3. MPI Parallelism Block\n4. MPI Parallelism Block Optimized\n5. MPI Batch of matrices All Gather\n6. MPI Hierarchical (node-aware) Transposition\n7. MPI All-to-all Exchange of Blocks\n8. MPI Autotuned (best mode, tile and exchange cached in tuningDatabase.csv)\n9. Baseline of the hardware (STREAM copy and MPI ping-pong) in baselineGeneral.csv\n10. Sweep of sizes, modes, tests and processes in a single launch (--sizes, --modes, --tests, --procs)\n11. MPI Distributed, every process generates and keeps only its slabs of rows (no matrices on rank 0)\n12. MPI Sparse, CSR matrix distributed by rows transposed exchanging only the nonzeros (--density)\n13. MPI Streaming, a stream of matrices transposed by a pipeline of scatter, transpose and gather (--stream)\n14. Comparison of the times of a results set (--current, default this directory) with a baseline one (--baseline), exit status 2 with slowdowns\n\n(3) Exponential of 2 from 4 to 12 (16->4, 64->6, 1024->10, 4096->12)\n\n(4) Testing:\n0. Matrix is generated randomly\n1. A default test matrix is generated according to an algorithm (used for testing, with one interaction in checkSym and Transposition)\n2. A default test symmetric matrix (only checkSym works)\n3. The worst case scenario with a symmetric matrix, with only the last element checked (N-1, N-2) different\n4. Near symmetric matrix, with rare mismatches\n5. Banded matrix, zeros out of the N/16 diagonals around the main one\n6. Blocked matrix, blocks of 32x32 equal elements\n\n(5) Number of samples (>=25)\n\n(6) Scaling Type:\n0. Strong Scaling (Size inputed partitioned of job among processes)\n1. Weak Scaling (Size inputed assigned to every process)\n\nOptional parameters (after the mandatory ones):\n--batch=B Number of matrices transposed together by mode 5 (default 8)\n--rows=R --cols=C Rectangular matrix R x C instead of the square one given by (3)\n--compress=BYTES Compress the exchanged messages of at least BYTES bytes\n--node-size=K Emulate nodes of K processes in mode 6\n--exchange=alltoall|pairwise|bruck|eklundh|overlap Schedule of the exchange of modes 7 and 11\n--baseline=DIR Results set compared by mode 14 with --current=DIR (default .), significant at --alpha=A (default 0.05) beyond --tolerance=T (default 0.05)\n--stream=PATH File or pipe with the raw floats of the matrices of mode 13 (default generated by a producer thread)\n--progress=1 Thread completing the non-blocking transfers of --exchange=overlap (MPI_THREAD_MULTIPLE), overlap in overlapGeneral.csv\n--tile=B Tiles of B x B elements in the local transposition, 0 untiled (default the biggest power of 2 up to 32 dividing the local matrix)\n--pack=manual|datatype Block of mode 4 sent transposed, packed with SSE (default) or by a derived datatype\n--warmup=W Samples discarded before the measured ones (default 2)\n--precision=P Keep sampling until the confidence interval of the median is within +-P of it\n--max-samples=M Maximum samples with --precision (default 1000)\n--phases=1 Time of each phase (min/avg/max among the processes) in phasesGeneral.csv\n--counters=1 Hardware counters of checksym and transpose (perf_event_open) in countersGeneral.csv\n--seed=S Seed of the random test 0 (default a new one at every run)\n--density=D Percentage of nonzeros of the sparse matrix of mode 12 (default 1)\n--packed=1 Store the symmetric test 2 of mode 11 packed (lower triangle), the transposition is an alias (times in packedGeneral.csv)\n--affinity=none|compact|scatter|partner Pinning of the processes and threads on the processors of the node (default none, left to mpirun)\n--cache=cold|warm|clflush Caches at the start of each sample: evicted by a flush buffer (default), warm or the matrices evicted with clflush\n--sizes=4:12 --modes=1:7 --tests=0,1 --procs=1,2,4 Lists (a,b,c) or ranges (a:b) of the sweep of mode 10\n\n");
+        exit(1);
+    }
+}
+/*
+ *  Name: valueInputed
+ *  Function that processes and validates the input values based on the argument provided. It checks if the input values are within valid ranges for different parameters (mode, dimension, test, samples, and number of threads). If any value is invalid, it prints an error message and exits the program.
+ *  Input:
+ *      argc (int) - The number of command-line arguments passed to the program
+ *      argv (const char*) - A string representing the argument value to be process
+ *      value (int) - The specific value identifying which input parameter is being validated (2. mode, 3. dimension, 4. test, 5. samples, 6. scaling)
+ *  Output:
+ *      returnValue (int) - The validated integer value for the corresponding parameter
+ */
+int valueInputed(int argc, const char* argv, int value) {
+    int returnValue=-1;
+    if(value>=2 && value<=6) {
+        switch (value) {
+            case 2: {
+               returnValue=atoi(argv);
+                if (returnValue<=START || returnValue>=END) {
+                    fprintf(stderr, "1. Sequential Code\n2. MPI Parallelism All Gather\n3. MPI Parallelism Block\n4. MPI Parallelism Block Optimized\n5. MPI Batch of matrices All Gather\n6. MPI Hierarchical (node-aware) Transposition\n7. MPI All-to-all Exchange of Blocks\n8. MPI Autotuned (best mode, tile and exchange cached in tuningDatabase.csv)\n9. Baseline of the hardware (STREAM copy and MPI ping-pong) in baselineGeneral.csv\n10. Sweep of sizes, modes, tests and processes in a single launch (--sizes, --modes, --tests, --procs)\n11. MPI Distributed, every process generates and keeps only its slabs of rows (no matrices on rank 0)\n12. MPI Sparse, CSR matrix distributed by rows transposed exchanging only the nonzeros (--density)\n13. MPI Streaming, a stream of matrices transposed by a pipeline of scatter, transpose and gather (--stream)\n14. Comparison of the times of a results set (--current, default this directory) with a baseline one (--baseline), exit status 2 with slowdowns\n\n");
+                    exit(1);
+                }
+            }
+            break;
+            case 3: {
+                returnValue=pow(2, atoi(argv));
+                if (returnValue<MIN_SIZE || returnValue>MAX_SIZE) {
+                    fprintf(stderr, "Invalid dimension, it has to be a power of 2 between 4 and 12. Insert the exponential\n\n");
+                    exit(1);
+                }
+            }
+            break;
+            case 4: {
+                returnValue=atoi(argv);
+                if(returnValue>=TESTS || returnValue<0) {
+                    fprintf(stderr, "Invalid testing, it has to be:\n\n0. (Random)\n1. (Standard Test No Symmetric)\n2. (Standard Test Symmetric)\n3. (Worst Case, symmetric except the last element checked)\n4. (Near Symmetric)\n5. (Banded)\n6. (Blocked)\n\n");
+                    exit(1);
+                }
+            }
+            break;
+            case 5: {
+                returnValue=atoi(argv);
+                if(returnValue<MIN_SAMPLES) {
+                    fprintf(stderr, "Invalid samples number, it has to be at least of 25\n\n");
+                    exit(1);
+                }
+            }
+            break;
+            case 6:
+                returnValue=atoi(argv);
+                if(returnValue!=0 && returnValue!=1) {
+                    fprintf(stderr, "Scaling Type:\n0. Strong Scaling (Size inputed partitioned of job among processes)\n1. Weak Scaling (Size inputed assigned to every process)\n\n");
+                    exit(1);
+                }
+            break;
+            default:
+                exit(1);
+                break;
+        }
+    }
+    return returnValue;
+}
+/*
+ *  Name: parseList
+ *  Function that reads a list of the sweep, given as values separated by commas (a,b,c), ranges (a:b) or both
+ *  (a:b,c). Values out of [min, max] or too many values stop the program.
+ *  Input:
+ *      list (const char*) - The text of the list
+ *      out (SweepList*) - The list where the values are stored
+ *      min (int) - The minimum value accepted
+ *      max (int) - The maximum value accepted
+ *      name (const char*) - The name of the parameter, for the error message
+ *  Output: none
+ */
+void parseList(const char* list, SweepList* out, int min, int max, const char* name) {
+    char* end;
+    out->count=0;
+    while(*list!='\0') {
+        long first=strtol(list, &end, 10);
+        long last=first;
+        if(end==list) {
+            break;
+        }
+        if(*end==':') {
+            list=end+1;
+            last=strtol(list, &end, 10);
+            if(end==list) {
+                break;
+            }
+        }
+        if(first<min || last>max || first>last) {
+            fprintf(stderr, "Invalid %s, the values have to be between %d and %d\n\n", name, min, max);
+            exit(1);
+        }
+        for (; first<=last; first++) {
+            if(out->count==MAX_SWEEP) {
+                fprintf(stderr, "Invalid %s, at most %d values\n\n", name, MAX_SWEEP);
+                exit(1);
+            }
+            out->values[out->count++]=(int)first;
+        }
+        list=(*end==',') ? end+1 : end;
+        if(*end!=',' && *end!='\0') {
+            break;
+        }
+    }
+    if(*list!='\0' || out->count==0) {
+        fprintf(stderr, "Invalid %s, it has to be a list of values a,b,c or of ranges a:b\n\n", name);
+        exit(1);
+    }
+}
+/*
+ *  Name: optionalParameters
+ *  Function that reads the optional parameters given after the mandatory ones, in the form --name=value, and stores them in the global options. Unknown or invalid parameters stop the program.
+ *  Input:
+ *      argc (int) - The number of command-line arguments passed to the program
+ *      argv (char**) - The command-line arguments
+ *  Output: none
+ */
+void optionalParameters(int argc, char* argv[]) {
+    int i, k;
+    options.batch=8;
+    options.rows=0;
+    options.cols=0;
+    options.compress=-1;
+    options.node_size=0;
+    options.exchange=PAIRWISE;
+    options.tile=-1;
+    options.warmup=2;
+    options.precision=0.0;
+    options.max_samples=1000;
+    options.phases=0;
+    options.counters=0;
+    options.cache=CACHE_COLD;
+    options.seed=0;
+    options.density=1.0;
+    options.packed=0;
+    options.affinity=AFFINITY_NONE;
+    options.progress=0;
+    options.stream=NULL;
+    options.pack=PACK_MANUAL;
+    options.baseline=NULL;
+    options.current=".";
+    options.alpha=0.05;
+    options.tolerance=0.05;
+    options.sweep_sizes.count=0;
+    options.sweep_modes.count=0;
+    for (i=SEQ; i<=MPI_EXCHANGE; i++) {
+        options.sweep_modes.values[options.sweep_modes.count++]=i;
+    }
+    options.sweep_tests.count=0;
+    options.sweep_procs.count=0;
+    for (i=7; i<argc; i++) {
+        if(strncmp(argv[i], "--batch=", 8)==0) {
+            options.batch=atoi(argv[i]+8);
+            if(options.batch<1 || options.batch>MAX_BATCH) {
+                fprintf(stderr, "Invalid batch, it has to be between 1 and %d\n\n", MAX_BATCH);
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--rows=", 7)==0 || strncmp(argv[i], "--cols=", 7)==0) {
+            int value=atoi(argv[i]+7);
+            if(value<1 || value>MAX_SIZE) {
+                fprintf(stderr, "Invalid %s, rows and columns have to be between 1 and %d\n\n", argv[i], (int)MAX_SIZE);
+                exit(1);
+            }
+            if(argv[i][2]=='r') {
+                options.rows=value;
+            }
+            else {
+                options.cols=value;
+            }
+        }
+        else if(strncmp(argv[i], "--node-size=", 12)==0) {
+            options.node_size=atoi(argv[i]+12);
+            if(options.node_size<1) {
+                fprintf(stderr, "Invalid node size, it has to be at least 1 process\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--sizes=", 8)==0) {
+            parseList(argv[i]+8, &options.sweep_sizes, (int)log2(MIN_SIZE), (int)log2(MAX_SIZE), "sizes");
+        }
+        else if(strncmp(argv[i], "--modes=", 8)==0) {
+            parseList(argv[i]+8, &options.sweep_modes, SEQ, MPI_SPARSE, "modes");
+            for (k=0; k<options.sweep_modes.count; k++) {
+                if(options.sweep_modes.values[k]==MPI_BASELINE || options.sweep_modes.values[k]==MPI_SWEEP) {
+                    fprintf(stderr, "Invalid modes, the sweep can't run the modes %d and %d\n\n", MPI_BASELINE, MPI_SWEEP);
+                    exit(1);
+                }
+            }
+        }
+        else if(strncmp(argv[i], "--tests=", 8)==0) {
+            parseList(argv[i]+8, &options.sweep_tests, RANDOM, TESTS-1, "tests");
+        }
+        else if(strncmp(argv[i], "--procs=", 8)==0) {
+            parseList(argv[i]+8, &options.sweep_procs, 1, MAX_THREADS, "procs");
+        }
+        else if(strncmp(argv[i], "--seed=", 7)==0) {
+            options.seed=strtoull(argv[i]+7, NULL, 10);
+            if(options.seed==0) {
+                fprintf(stderr, "Invalid seed, it has to be a positive integer\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--density=", 10)==0) {
+            options.density=atof(argv[i]+10);
+            if(options.density*SPARSE_SCALE/100<1.0 || options.density>100.0) {
+                fprintf(stderr, "Invalid density, it has to be a percentage of nonzeros between %g and 100\n\n", 100.0/SPARSE_SCALE);
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--packed=", 9)==0) {
+            options.packed=atoi(argv[i]+9);
+            if(options.packed!=0 && options.packed!=1) {
+                fprintf(stderr, "Invalid packed, it has to be 0 (full storage) or 1 (lower triangle of the symmetric test)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--stream=", 9)==0) {
+            options.stream=argv[i]+9;
+            if(options.stream[0]=='\0') {
+                fprintf(stderr, "Invalid stream, it has to be the path of a file or of a pipe\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--progress=", 11)==0) {
+            options.progress=atoi(argv[i]+11);
+            if(options.progress!=0 && options.progress!=1) {
+                fprintf(stderr, "Invalid progress, it has to be 0 (transfers progressed by the MPI calls) or 1 (progress thread)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--affinity=", 11)==0) {
+            int k;
+            for (k=AFFINITY_NONE; k<=AFFINITY_PARTNER && strcmp(argv[i]+11, affinityName((Affinity)k))!=0; k++);
+            if(k>AFFINITY_PARTNER) {
+                fprintf(stderr, "Invalid affinity, it has to be none, compact, scatter or partner\n\n");
+                exit(1);
+            }
+            options.affinity=(Affinity)k;
+        }
+        else if(strncmp(argv[i], "--pack=", 7)==0) {
+            const char* names[2]={"manual", "datatype"};
+            int k;
+            for (k=0; k<2 && strcmp(argv[i]+7, names[k])!=0; k++);
+            if(k==2) {
+                fprintf(stderr, "Invalid pack, it has to be manual or datatype\n\n");
+                exit(1);
+            }
+            options.pack=(Packing)k;
+        }
+        else if(strncmp(argv[i], "--cache=", 8)==0) {
+            const char* names[3]={"cold", "warm", "clflush"};
+            int k;
+            for (k=0; k<3 && strcmp(argv[i]+8, names[k])!=0; k++);
+            if(k==3) {
+                fprintf(stderr, "Invalid cache, it has to be cold, warm or clflush\n\n");
+                exit(1);
+            }
+            options.cache=(CacheState)k;
+        }
+        else if(strncmp(argv[i], "--exchange=", 11)==0) {
+            const char* names[EXCHANGES]={"alltoall", "pairwise", "bruck", "eklundh", "overlap"};
+            int k;
+            for (k=0; k<EXCHANGES && strcmp(argv[i]+11, names[k])!=0; k++);
+            if(k==EXCHANGES) {
+                fprintf(stderr, "Invalid exchange, it has to be alltoall, pairwise, bruck, eklundh or overlap\n\n");
+                exit(1);
+            }
+            options.exchange=(Exchange)k;
+        }
+        else if(strncmp(argv[i], "--tile=", 7)==0) {
+            options.tile=atoi(argv[i]+7);
+            if(options.tile<0 || options.tile>MAX_TILE) {
+                fprintf(stderr, "Invalid tile, it has to be between 0 (untiled) and %d\n\n", MAX_TILE);
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--warmup=", 9)==0) {
+            options.warmup=atoi(argv[i]+9);
+            if(options.warmup<0) {
+                fprintf(stderr, "Invalid warm-up, it has to be a number of samples >= 0\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--baseline=", 11)==0) {
+            options.baseline=argv[i]+11;
+        }
+        else if(strncmp(argv[i], "--current=", 10)==0) {
+            options.current=argv[i]+10;
+        }
+        else if(strncmp(argv[i], "--alpha=", 8)==0) {
+            options.alpha=atof(argv[i]+8);
+            if(options.alpha<=0.0 || options.alpha>=1.0) {
+                fprintf(stderr, "Invalid alpha, it has to be a significance level between 0 and 1 (for example 0.01)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--tolerance=", 12)==0) {
+            options.tolerance=atof(argv[i]+12);
+            if(options.tolerance<0.0 || options.tolerance>=1.0) {
+                fprintf(stderr, "Invalid tolerance, it has to be a fraction of the median between 0 and 1 (for example 0.05)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--precision=", 12)==0) {
+            options.precision=atof(argv[i]+12);
+            if(options.precision<=0.0 || options.precision>=1.0) {
+                fprintf(stderr, "Invalid precision, it has to be a fraction of the median between 0 and 1 (for example 0.02)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--max-samples=", 14)==0) {
+            options.max_samples=atoi(argv[i]+14);
+            if(options.max_samples<MIN_SAMPLES) {
+                fprintf(stderr, "Invalid maximum samples, it has to be at least %d\n\n", MIN_SAMPLES);
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--phases=", 9)==0) {
+            options.phases=atoi(argv[i]+9);
+            if(options.phases!=0 && options.phases!=1) {
+                fprintf(stderr, "Invalid phases, it has to be 0 (disabled) or 1 (time of each phase)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--counters=", 11)==0) {
+            options.counters=atoi(argv[i]+11);
+            if(options.counters!=0 && options.counters!=1) {
+                fprintf(stderr, "Invalid counters, it has to be 0 (disabled) or 1 (hardware counters of the local kernels)\n\n");
+                exit(1);
+            }
+        }
+        else if(strncmp(argv[i], "--compress=", 11)==0) {
+            options.compress=atoll(argv[i]+11);
+            if(options.compress<0) {
+                fprintf(stderr, "Invalid compression threshold, it has to be a number of bytes >= 0\n\n");
+                exit(1);
+            }
+        }
+        else {
+            fprintf(stderr, "Unknown optional parameter %s\n\n", argv[i]);
+            exit(1);
+        }
+    }
+}
+/*
+ *  Name: mixBits
+ *  Function that mixes the bits of a 64 bit counter (finalizer of SplitMix64), the generator of the elements.
+ *  Input:
+ *      x (unsigned long long) - The counter
+ *  Output: unsigned long long - The mixed bits
+ */
+unsigned long long mixBits(unsigned long long x) {
+    x+=0x9E3779B97F4A7C15ULL;
+    x=(x^(x>>30))*0xBF58476D1CE4E5B9ULL;
+    x=(x^(x>>27))*0x94D049BB133111EBULL;
+    return x^(x>>31);
+}
+/*
+ *  Name: counterFloat
+ *  Function that generates the element (i, j) from its position only, with the same range of random_float2(0, 9999)
+ *  (values from 0 to 99.99 with 2 decimals). No state is shared among the elements, so any element can be generated
+ *  by any thread or process in any order.
+ *  Input:
+ *      seed (unsigned long long) - The seed of the matrix
+ *      i (long long) - The row of the element
+ *      j (long long) - The column of the element
+ *  Output: float - The value of the element
+ */
+float counterFloat(unsigned long long seed, long long i, long long j) {
+    return (float)((mixBits(seed^(((unsigned long long)i<<32)|(unsigned long long)j))%10000)*1.0/100);
+}
+/*
+ *  Name: nearSymMismatch
+ *  Function that gives the position of the mismatch k of the test NEAR_SYM, under the diagonal in the second half of
+ *  the rows of a square N x N matrix (N>1), from the seed of the matrix only.
+ *  Input:
+ *      matrix_seed (unsigned long long) - The seed of the matrix
+ *      k (int) - The mismatch, from 0 to NEAR_SYM_MISMATCHES-1
+ *      N (int) - The number of rows and columns of the matrix
+ *      row (long long*) - The row of the mismatch
+ *      col (long long*) - The column of the mismatch, lower than row
+ *  Output: none
+ */
+void nearSymMismatch(unsigned long long matrix_seed, int k, int N, long long* row, long long* col) {
+    *row=N/2+(long long)(mixBits(matrix_seed+k)%(unsigned long long)(N-N/2));
+    *col=(long long)(mixBits(~(matrix_seed+k))%(unsigned long long)*row);
+}
+/*
+ *  Name: initializeMatrix
+ *  Function that initializes the rows first..first+x-1 of a matrix (or of a batch of matrices stored one after the other) based on test. Every element is a function of its position and of the seed only (counterFloat), so the matrix is the same whatever the threads or the processes generating it, and the rows are generated in parallel by OpenMP when compiled with -fopenmp:
+ *      RANDOM - Random values with the seed of the run (--seed)
+ *      STATIC - Random values with the fixed seed STATIC_SEED, the same at every run (as the tests below)
+ *      SYM - All the elements equal
+ *      WORST - Symmetric random values except the element (N-1, N-2), the last one compared by the check of symmetry
+ *      NEAR_SYM - Symmetric random values except NEAR_SYM_MISMATCHES elements under the diagonal in the second half of the rows
+ *      BANDED - Random values on the N/BAND_FRACTION diagonals around the main one, zeros elsewhere
+ *      BLOCKED - Blocks of BLOCK_SIDE x BLOCK_SIDE elements with the same random value
+ *  Input:
+ *      M (float**) - The rows to be initialized, contiguous (x rows and C columns)
+ *      test (Test) - The test type that determines how the matrix will be initialized (0 to 6)
+ *      first (int) - The row of the batch of the first row to initialize
+ *      x (int) - The number of rows to initialize
+ *      N (int) - The number of rows of each matrix
+ *      C (int) - The number of columns of each matrix
+ *  Output: none
+ */
+void initializeMatrix(float** M, Test test, int first, int x, int N, int C) {
+    const unsigned long long seed=(test==RANDOM) ? options.seed : STATIC_SEED;
+    const int band=MAX(N/BAND_FRACTION, 1);
+    int i;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i=0; i<x; i++) {
+        const long long r=(first+i)%N;
+        //Each matrix of a batch has its own seed
+        const unsigned long long matrix_seed=mixBits(seed+(unsigned long long)((first+i)/N));
+        float* row=M[i];
+        int j;
+        switch (test) {
+            case RANDOM:
+            case STATIC:
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+                for (j=0; j<C; j++) {
+                    row[j]=counterFloat(matrix_seed, r, j);
+                }
+                break;
+            case SYM:
+                for (j=0; j<C; j++) {
+                    row[j]=5.0;
+                }
+                break;
+            case WORST:
+            case NEAR_SYM:
+                //The element (i, j) is generated from the pair (max, min), so it's equal to (j, i)
+                for (j=0; j<C; j++) {
+                    row[j]=(r>=j) ? counterFloat(matrix_seed, r, j) : counterFloat(matrix_seed, j, r);
+                }
+                if(test==WORST && N==C && r==N-1 && N>1) {
+                    row[N-2]+=1.0f;
+                }
+                if(test==NEAR_SYM && N==C && N>1) {
+                    int k;
+                    long long mismatch_row, mismatch_col;
+                    for (k=0; k<NEAR_SYM_MISMATCHES; k++) {
+                        nearSymMismatch(matrix_seed, k, N, &mismatch_row, &mismatch_col);
+                        if(mismatch_row==r) {
+                            row[mismatch_col]+=1.0f;
+                        }
+                    }
+                }
+                break;
+            case BANDED:
+                for (j=0; j<C; j++) {
+                    row[j]=(j>=r-band && j<=r+band) ? counterFloat(matrix_seed, r, j) : 0.0f;
+                }
+                break;
+            case BLOCKED:
+                for (j=0; j<C; j++) {
+                    row[j]=counterFloat(matrix_seed, r/BLOCK_SIDE, j/BLOCK_SIDE);
+                }
+                break;
+            default: fprintf(stderr, "Unexpected Error\n"); exit(1);
+        }
+    }
+}
+/*
+ * Name: createTransposed
+ * Allocates on rank 0 the transposed matrix gathered by the transpositions, only once the check of symmetry found
+ * that it's needed, and points globalrecvptr to it.
+ *
+ * Input:
+ *      TGEN (float***) - The transposed matrix to allocate
+ *      x (int) - The number of rows of the transposed matrix (the columns of all the matrices of the batch)
+ *      y (int) - The number of columns of the transposed matrix
+ *      rank (int) - The MPI rank of the current process
+ *
+ * Output: none
+ */
+void createTransposed(float*** TGEN, int x, int y, int rank) {
+    if(rank==0) {
+        create2DFloatMatrix(TGEN, x, y);
+        globalrecvptr=&((*TGEN)[0][0]);
+    }
+}
+/*
+ * Name: executionProgram
+ * Executes the program based on the given mode, and performs matrix transposition using different MPI strategies.
+ * This function checks if the matrix is symmetric and, if not, performs the transposition using different strategies.
+ *
+ * Input:
+ *      MGEN (float**) - The generated matrix, typically the global matrix to check symmetry against.
+ *      M (float**) - The local matrix for the current MPI rank.
+ *      T (float**) - The matrix where the transposed result is stored.
+ *      TGEN (float***) - The transposed matrix of rank 0, allocated only when the transposition is needed and an
+ *                        alias of MGEN (no copy) when the matrix is symmetric.
+ *      tempM (float**) - A temporary matrix used for optimized block transposition.
+ *      mode (Mode) - The execution mode (SEQ, MPI_ALL, MPI_BLOCK, MPI_BLOCK_OPT, MPI_BATCH, MPI_HIER, MPI_EXCHANGE or MPI_DISTRIBUTED).
+ *      N (int) - The number of rows of the matrix (N x C), in weak scaling the rows of all the processes.
+ *      C (int) - The number of columns of the matrix.
+ *      rows (int) - The number of rows assigned to the current rank.
+ *      cols (int) - The number of columns assigned to the current rank (C for the modes working on rows).
+ *      rank (int) - The MPI rank of the current process.
+ *      sending (DataCommunicate) - Structure containing the sending data for MPI operations.
+ *      receiving (DataCommunicate) - Structure containing the receiving data for MPI operations.
+ *      sender_mpi_all (Communicator2D) - The MPI communicator for the 2D process grid (scatter of a batch in mode MPI_BATCH).
+ *      gather_mpi_all (Communicator2D) - The type of a transposed slab of a batch (used only in mode MPI_BATCH).
+ *      column (MPI_Datatype) - The column of the block of the plan (used only in mode MPI_BLOCK_OPT with --pack=datatype).
+ *
+ * Output:
+ *      bool - True if the matrix is symmetric and no transposition was needed, false if the matrix was not symmetric
+ *   and the transposition was performed.
+ */
+
+bool executionProgram(float** MGEN, float** M, float** T, float*** TGEN, float** tempM, Mode mode, int N, int C, int rows, int cols, int rank, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender_mpi_all, Communicator2D gather_mpi_all, MPI_Datatype column, TransposeKernel kernel) {
+    switch (mode) {
+        case SEQ:
+        case MPI_ALL: {
+            if(!checkSymMPI(MGEN, N, C, rank)) {
+                createTransposed(TGEN, C, N, rank);
+                matTransposeMPIAllGather(MGEN, M, T, *TGEN, rank, N, C, rows, sending, receiving, kernel);
+                return false;
+            }
+        }
+        break;
+        case MPI_BLOCK: {
+            if(!checkSymMPI(MGEN, N, C, rank)) {
+                createTransposed(TGEN, C, N, rank);
+                matTransposeMPIBlock(MGEN, M, T, *TGEN, rank, N, C, rows, cols, sending, receiving, kernel);
+                return false;
+            }
+        }
+        break;
+        case MPI_BLOCK_OPT: {
+            if(!checkSymMPI(MGEN, N, C, rank)) {
+                createTransposed(TGEN, C, N, rank);
+                matTransposeMPIBlockOPT(MGEN, M, T, *TGEN, tempM, rank, N, C, rows, cols, sending, receiving, column);
+                return false;
+            }
+        }
+        break;
+        case MPI_BATCH: {
+            if(!checkSymMPIBatch(MGEN, N, C, rank, options.batch)) {
+                createTransposed(TGEN, options.batch*C, N, rank);
+                matTransposeMPIBatch(M, T, C, rows, options.batch, sending, sender_mpi_all, gather_mpi_all, kernel);
+                return false;
+            }
+        }
+        break;
+        case MPI_HIER: {
+            if(!checkSymMPI(MGEN, N, C, rank)) {
+                createTransposed(TGEN, C, N, rank);
+                matTransposeMPIHierarchical(M, T, rank, N, C, rows, cols, sending, receiving, sender_mpi_all);
+                return false;
+            }
+        }
+        break;
+        case MPI_EXCHANGE: {
+            if(!checkSymMPI(MGEN, N, C, rank)) {
+                createTransposed(TGEN, C, N, rank);
+                matTransposeMPIExchange(M, T, rank, N, C, rows, cols, sending, receiving, sender_mpi_all);
+                return false;
+            }
+        }
+        break;
+        case MPI_DISTRIBUTED: {
+            //The check needs the rows of the other processes, so it compares the slabs after the transposition
+            matTransposeMPIDistributed(M, T, rows, cols);
+            if(!checkSymDistributed(M, T, N, C, rows)) {
+                return false;
+            }
+        }
+        break;
+        default:
+            MPI_Finalize();
+            exit(1);
+            break;
+    }
+    //freeMemory(T, N);
+    //freeMemory(TLM, rows);
+    //The transposed of a symmetric matrix is the matrix itself, given back without copying it
+    if(rank==0 && mode!=MPI_DISTRIBUTED) {
+        *TGEN=MGEN;
+    }
+    return true;
+}
+/*
+ * Name: executionSparse
+ * Executes the mode MPI_SPARSE: as in MPI_DISTRIBUTED the check needs the rows of the other processes, so the
+ * sparse matrix is transposed and then the slabs are compared.
+ *
+ * Input:
+ *      A (Sparse*) - The local slab of the start matrix
+ *      T (Sparse*) - The local slab of the transposed matrix
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *
+ * Output:
+ *      bool - True if the matrix is symmetric, false otherwise (the transposition is done anyway)
+ */
+bool executionSparse(Sparse* A, Sparse* T, int N, int C) {
+    matTransposeMPISparse(A, T, C);
+    return checkSymSparse(A, T, N, C);
+}
+/*
+ * Name: createPlan
+ * Prepares on a communicator everything that a configuration reuses in all its samples: the decomposition of the
+ * matrix (grid of processes for the block modes, slabs of rows for the others), the Cartesian or duplicated
+ * communicator that becomes actual_comm, the counts and displacements of scatter and gather and, in mode
+ * MPI_HIER, the shared windows of the nodes. The checks depend only on the sizes and on the processes, so all
+ * the ranks agree on the result.
+ *
+ * Input:
+ *      plan (Plan*) - The plan to initialize
+ *      comm (MPI_Comm) - The communicator of the processes running the configuration
+ *      mode (Mode) - The execution mode (SEQ, MPI_ALL, MPI_BLOCK, MPI_BLOCK_OPT, MPI_BATCH, MPI_HIER, MPI_EXCHANGE, MPI_DISTRIBUTED or MPI_SPARSE)
+ *      exchange (Exchange) - The schedule of the all-to-all exchange of modes MPI_EXCHANGE and MPI_DISTRIBUTED
+ *      tile (int) - The side of the tiles of the local transposition (0 untiled, -1 chosen by defaultTile)
+ *      N (int) - The number of rows of the matrix (N x C), in weak scaling the rows of all the processes
+ *      C (int) - The number of columns of the matrix
+ *      batch (int) - The number of matrices transposed together (1 except in mode MPI_BATCH)
+ *
+ * Output:
+ *      bool - True if the configuration can run on the communicator, false otherwise (nothing to free)
+ */
+bool createPlan(Plan* plan, MPI_Comm comm, Mode mode, Exchange exchange, int tile, int N, int C, int batch) {
+    int rank, num_procs;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+    plan->mode=mode;
+    plan->exchange=exchange;
+    plan->tile=tile;
+    plan->N=N;
+    plan->C=C;
+    plan->batch=batch;
+    plan->parent=comm;
+    plan->n_x=1;
+    plan->n_y=1;
+    plan->rows=1;
+    plan->cols=1;
+    plan->column=MPI_DATATYPE_NULL;
+    plan->kernel=NULL;
+    if(options.packed==1 && mode!=MPI_DISTRIBUTED) {
+        //In the other modes the packed matrix would only be broadcast and aliased, never transposed
+        printf("The packed storage (--packed=1) works only with the distributed mode %d\n", MPI_DISTRIBUTED);
+        return false;
+    }
+    if(mode==MPI_BLOCK || mode==MPI_BLOCK_OPT) {
+        //Independent decomposition of rows (n_x) and columns (n_y), not forced to a square grid
+        int dims[2]={0, 0};
+        MPI_Dims_create(num_procs, 2, dims);
+        plan->n_x=dims[0];
+        plan->n_y=dims[1];
+        plan->rows=N/plan->n_x;
+        plan->cols=C/plan->n_y;
+        if(N%plan->n_x!=0 || C%plan->n_y!=0) {
+            printf("The grid %dx%d of %d processes doesn't divide the matrix %dx%d\n", plan->n_x, plan->n_y, num_procs, N, C);
+            return false;
+        }
+        int periods[2]={1, 1};
+        int reorder=1;
+        MPI_Comm grid_parent=comm;
+        if(topology.domain>=0) {
+            //Pinned processes: the partners on the same socket instead of the reorder of the implementation
+            reorderPartners(comm, dims, &grid_parent);
+            reorder=0;
+        }
+        MPI_Cart_create(grid_parent, 2, dims, periods, reorder, &plan->comm);
+        if(grid_parent!=comm) {
+            MPI_Comm_free(&grid_parent);
+        }
+        actual_comm=plan->comm;
+        MPI_Comm_rank(actual_comm, &transposer.rank_start);
+        MPI_Cart_coords(actual_comm, transposer.rank_start, 2, transposer.coords_start);
+        //The block (i, j) goes in position (j, i) of the transposed grid n_y x n_x, owned by the rank j*n_x+i
+        transposer.rank_dest=transposer.coords_start[1]*plan->n_x+transposer.coords_start[0];
+        MPI_Cart_coords(actual_comm, transposer.rank_dest, 2, transposer.coords_dest);
+        //The block owned in the transposed grid comes from the block (rank%n_x, rank/n_x) of the original one
+        transposer.coords_src[0]=transposer.rank_start%plan->n_x;
+        transposer.coords_src[1]=transposer.rank_start/plan->n_x;
+        MPI_Cart_rank(actual_comm, transposer.coords_src, &transposer.rank_src);
+        printf("Rank %d -> Cartesian Rank Start %d, Coordinates (%d, %d) - Cartesian Rank End %d, Coordinates (%d, %d) - Cartesian Rank Source %d, Coordinates (%d, %d)\n", rank, transposer.rank_start, transposer.coords_start[0], transposer.coords_start[1], transposer.rank_dest, transposer.coords_dest[0], transposer.coords_dest[1], transposer.rank_src, transposer.coords_src[0], transposer.coords_src[1]);
+        MPI_Barrier(actual_comm);
+        createData(&plan->sending, plan->n_x, plan->n_y);
+        createData(&plan->receiving, plan->n_y, plan->n_x);
+        if(mode==MPI_BLOCK_OPT && options.pack==PACK_DATATYPE) {
+            //A column of the block, resized to a float so the cols columns follow one another, created once for all the samples
+            MPI_Datatype column;
+            MPI_Type_vector(plan->rows, 1, plan->cols, MPI_FLOAT, &column);
+            MPI_Type_create_resized(column, 0, sizeof(float), &plan->column);
+            MPI_Type_commit(&plan->column);
+            MPI_Type_free(&column);
+        }
     }
-    //int lines=countFile(file);
-    FILE* wc=NULL;
-    if(type==1) {
-        wc=popen("wc -l < resultsGeneral.csv", "r");
+    else {
+        if(mode==SEQ && num_procs!=1) {
+            printf("This mode can be run only with 1 process\n");
+            return false;
+        }
+        if(mode==MPI_BATCH && N%num_procs!=0) {
+            printf("The batch mode works only in strong scaling with a number of processes %d dividing N=%d\n", num_procs, N);
+            return false;
+        }
+        if (N % num_procs == 0) {
+            plan->rows=N/num_procs;
+        } else {
+            plan->rows=N/num_procs+(rank<N%num_procs ? 1 : 0);
+        }
+        plan->cols=C;
+        if(mode==MPI_SPARSE) {
+            //Rows of the transposed matrix, the slice of the columns split as the rows (also when they don't divide)
+            plan->cols=C/num_procs+(rank<C%num_procs ? 1 : 0);
+        }
+        if(mode==MPI_HIER || mode==MPI_EXCHANGE || mode==MPI_DISTRIBUTED) {
+            //Also the transposed matrix stays distributed by rows, C/num_procs per process
+            if(N%num_procs!=0 || C%num_procs!=0) {
+                printf("The hierarchical, exchange and distributed modes work only with a number of processes %d dividing the matrix %dx%d\n", num_procs, N, C);
+                return false;
+            }
+            if((mode==MPI_EXCHANGE || mode==MPI_DISTRIBUTED) && exchange==EKLUNDH && (num_procs&(num_procs-1))!=0) {
+                printf("The exchange of Eklundh works only with a number of processes %d power of 2\n", num_procs);
+                return false;
+            }
+            plan->cols=C/num_procs;
+        }
+        plan->n_y=num_procs;
+        MPI_Comm_dup(comm, &plan->comm);
+        actual_comm=plan->comm;
+        printf("Hello rank %d out of %d\n", rank+1, num_procs);
+        //For create data x for columns y for rows
+        createData(&plan->sending, 1, num_procs);
+        createData(&plan->receiving, 1, plan->n_y);
+        if(rank==0 && (mode==SEQ || mode==MPI_ALL)) {
+            //Slabs of different sizes when the processes don't divide N, scattered as floats and gathered as rows
+            balancePartition(&plan->sending, N, C);
+            balancePartition(&plan->receiving, N, 1);
+        }
+        else if(rank==0) {
+            dataPopulate(&plan->sending, 1, 0, 1, 0);
+            if(mode==MPI_HIER || mode==MPI_EXCHANGE) {
+                dataPopulate(&plan->receiving, plan->cols*N, 0, plan->cols*N, 0);
+            }
+        }
     }
-    else{
-        if (type==0) {
-            wc=popen("wc -l < timesGeneral.csv", "r");
+    if(mode==SEQ || mode==MPI_ALL || mode==MPI_BLOCK || mode==MPI_BATCH) {
+        //Local transposition of rows x cols (the block, or the whole rows): the tile of the shape if not given and its kernel
+        if(plan->tile<0) {
+            plan->tile=defaultTile(plan->rows, plan->cols);
         }
+        plan->kernel=selectKernel(plan->rows, plan->cols, plan->tile);
     }
-    if (wc==NULL) {
-        fprintf(stderr, "Error running wc -l\n");
-        fclose(file);
-        exit(1);
+    if(mode==MPI_HIER) {
+        setupHierarchy(&hierarchy, plan->rows*C, plan->cols*N);
     }
-    int lines;
-    fscanf(wc, "%d", &lines);
-    fclose(wc);
-    if(lines==0){
-        lines=1;
+    return true;
+}
+/*
+ * Name: runSample
+ * Runs one sample of a plan: frees the caches, allocates and initializes the start matrix, broadcasts it, allocates
+ * the submatrices of the mode and measures the check of symmetry and the transposition done by executionProgram,
+ * then frees everything. The processes start the measure after a barrier and the time of the sample is the
+ * maximum among them, reduced on rank 0.
+ *
+ * Input:
+ *      plan (Plan*) - The plan created by createPlan
+ *      test (Test) - The test used to initialize the matrix
+ *      rank (int) - The rank of the current MPI process
+ *      report (bool) - If true rank 0 prints the result of the check, the time and the control of the transposition
+ *
+ * Output:
+ *      double - The time of the slowest process on rank 0 (of the whole batch in mode MPI_BATCH), 0 on the other ranks
+ */
+double runSample(Plan* plan, Test test, int rank, bool report) {
+    float** M=NULL;
+    float** MGEN=NULL;
+    float** T=NULL;
+    float** TGEN=NULL;
+    float** tempM=NULL;
+    double time=0.0, tw_start=0.0;
+    long long m_count=0, t_count=0;
+    const Mode mode=plan->mode;
+    const int N=plan->N, C=plan->C, B=plan->batch, rows=plan->rows, cols=plan->cols;
+    Communicator2D sender_mpi_all;
+    Communicator2D gather_mpi_all;
+    Communicator2D gen_matrix;
+    int size[2]={B*N, C};
+    int subsizes[2]={B*N, C};
+    int starts[2]={0, 0};
+    actual_comm=plan->comm;
+    options.exchange=plan->exchange;
+    if(mode==MPI_SPARSE) {
+        return runSampleSparse(plan, test, rank, report);
     }
-    double seq_time = 0.0;
-    double speedup=0.0;
-    double efficiency=0.0;
-    if(num_procs!=1 && type==1) {
-        fclose(file);
-        seq_time=getSequential(dim, code, mode, test, scaling);
-        file=fopen(filename, "a+"); //read and append
-        if(file==NULL) {
-            fprintf(stderr, "Couldn't open or create %s\n", filename);
-            exit(1);
+    if(usePacked(mode, test, N, C)) {
+        return runSamplePacked(plan, test, rank, report);
+    }
+    //Allocation in memory
+    if(mode==MPI_DISTRIBUTED) {
+        //Only the slabs of the process, generated by itself, the whole matrices never exist
+        create2DFloatMatrix(&M, rows, C);
+        create2DFloatMatrix(&T, cols, N);
+        m_count=(long long)rows*C;
+        t_count=(long long)cols*N;
+        initializeMatrix(M, test, rank*rows, rows, N, C);
+    }
+    else {
+        //In weak scaling N=N*NUM_PROCS, so the start matrix is (N*NUM_PROCS)xC and the destination Cx(N*NUM_PROCS)
+        create2DFloatMatrix(&MGEN, B*N, C);
+        if(rank==0) {
+            //The transposed matrix is allocated by executionProgram only if the matrix isn't symmetric
+            initializeMatrix(MGEN, test, 0, B*N, N, C);
         }
-        speedup=seq_time/avg_time;
-        if(scaling==0) {
-            efficiency=speedup/num_procs*100;
+        globalsendptr=&(MGEN[0][0]);
+        //Broadcasting the main matrix to all processes
+        setupCommunicator(&gen_matrix, size, subsizes, starts, subsizes[0]*subsizes[1]);
+        commitCommunicator(&gen_matrix);
+        PHASE_BEGIN(PHASE_BCAST);
+        MPI_Bcast(globalsendptr, 1, gen_matrix.resized_type, 0, actual_comm);
+        PHASE_END(PHASE_BCAST);
+        freeCommunicator(&gen_matrix);
+    }
+    //Allocate submatrices
+    if(mode==MPI_ALL || mode==SEQ || mode==MPI_HIER || mode==MPI_EXCHANGE) {
+        create2DFloatMatrix(&M, rows, C);
+        m_count=(long long)rows*C;
+        if(mode==MPI_HIER || mode==MPI_EXCHANGE) {
+            create2DFloatMatrix(&T, cols, N);
+            t_count=(long long)cols*N;
         }
         else {
-            efficiency=speedup*100;
+            create2DFloatMatrix(&T, C, rows);
+            t_count=(long long)C*rows;
+        }
+        if(mode==MPI_HIER || mode==MPI_EXCHANGE) {
+            size[0]=N;
+            size[1]=C;
+            subsizes[0]=rows;
+            subsizes[1]=C;
+            setupCommunicator(&sender_mpi_all, size, subsizes, starts, subsizes[0]*subsizes[1]);
+            commitCommunicator(&sender_mpi_all);
         }
     }
     else {
-        seq_time=avg_time;
-        speedup=seq_time/avg_time;
-        if(scaling==0) {
-            efficiency=speedup/num_procs*100;
+        if(mode==MPI_BLOCK || mode==MPI_BLOCK_OPT) {
+            create2DFloatMatrix(&M, rows, cols);
+            create2DFloatMatrix(&T, cols, rows);
+            m_count=t_count=(long long)rows*cols;
         }
-        else {
-            efficiency=speedup*100;
+        if(mode==MPI_BLOCK_OPT) {
+            create2DFloatMatrix(&tempM, rows, cols);
+        }
+        if(mode==MPI_BATCH) {
+            create2DFloatMatrix(&M, B*rows, C);
+            create2DFloatMatrix(&T, B*C, rows);
+            m_count=t_count=(long long)B*rows*C;
+            setupBatchCommunicators(&sender_mpi_all, &gather_mpi_all, B, N, C, rows);
+            commitCommunicator(&sender_mpi_all);
+            commitCommunicator(&gather_mpi_all);
         }
     }
-    fseek(file, 0, SEEK_END);
-    long long file_size=ftell(file);
-    if(file_size==0 && type==1) {
-        fprintf(file, "%-10s %-15s %-5s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-10s %-10s\n", "N°", "Compile", "Mode", "Dimension", "Test_Mode", "Samples", "N Procs", "Scaling", "Avg_Time(s)", "Seq_time(s)", "Speedup", "Efficiency");
+    localrecvptr=&(M[0][0]);
+    //Caches cold (or warm with --cache=warm) at the start of the sample, after the initialization and the broadcast
+    const void* const flushed[4]={(MGEN!=NULL) ? &(MGEN[0][0]) : NULL, &(M[0][0]), &(T[0][0]), (tempM!=NULL) ? &(tempM[0][0]) : NULL};
+    const long long flushed_sizes[4]={(long long)B*N*C*(long long)sizeof(float), m_count*(long long)sizeof(float), t_count*(long long)sizeof(float), (long long)rows*cols*(long long)sizeof(float)};
+    flushCache(flushed, flushed_sizes, 4);
+    //The generic loops of matTranspose use the tile resolved by the plan, the requested one (-1 by shape) stays for the next plans
+    const int requested_tile=options.tile;
+    options.tile=plan->tile;
+    //Starting Transposition, all the processes start together and the sample lasts until the slowest one ends
+    MPI_Barrier(actual_comm);
+    tw_start=MPI_Wtime();
+    bool symmetry=executionProgram(MGEN, M, T, &TGEN, tempM, mode, N, C, rows, cols, rank, plan->sending, plan->receiving, sender_mpi_all, gather_mpi_all, plan->column, plan->kernel);
+    //Ending Transposition
+    const double elapsed=MPI_Wtime()-tw_start;
+    options.tile=requested_tile;
+    MPI_Reduce(&elapsed, &time, 1, MPI_DOUBLE, MPI_MAX, 0, actual_comm);
+    if(rank==0) {
+        if(report) {
+            if (symmetry) {
+                printf("The matrix is symmetric.\n");
+            } else {
+                printf("The matrix is NOT symmetric.\n");
+            }
+            printf("Time Elapsed (get time)=%.12f\n", time);
+            if(!symmetry && mode==MPI_DISTRIBUTED) {
+                controlDistributed(M, T, rows, cols);
+            }
+            else if(!symmetry) {
+                control(MGEN, TGEN, N, C);
+            }
+        }
     }
-    else {
-        if(file_size==0 && type==0) {
-            fprintf(file, "%-10s %-15s %-5s %-10s %-10s %-10s %-10s %-10s %-15s\n", "N°", "Compile", "Mode", "Dimension", "Test_Mode", "Samples", "N Procs", "Scaling", "Time(s)");
+    //Freeing elements, TGEN is an alias of MGEN when the matrix is symmetric
+    if(TGEN!=NULL && TGEN!=MGEN) {
+        free2DMemory(&TGEN);
+    }
+    if(MGEN!=NULL) {
+        free2DMemory(&MGEN);
+    }
+    free2DMemory(&M);
+    free2DMemory(&T);
+    if(mode==MPI_HIER || mode==MPI_EXCHANGE) {
+        freeCommunicator(&sender_mpi_all);
+    }
+    if(mode==MPI_BLOCK_OPT) {
+        free2DMemory(&tempM);
+    }
+    if(mode==MPI_BATCH) {
+        freeCommunicator(&sender_mpi_all);
+        freeCommunicator(&gather_mpi_all);
+    }
+    MPI_Barrier(actual_comm);
+    return time;
+}
+/*
+ * Name: runSampleSparse
+ * Runs one sample of a plan of mode MPI_SPARSE as runSample: every process generates its slab of rows of the
+ * sparse matrix in CSR (initializeSparse) and the transposition is measured from the barrier to the end of the
+ * check, with the time of the slowest process reduced on rank 0.
+ *
+ * Input:
+ *      plan (Plan*) - The plan created by createPlan
+ *      test (Test) - The test used to initialize the matrix
+ *      rank (int) - The rank of the current MPI process
+ *      report (bool) - If true rank 0 prints the result of the check, the nonzeros, the time and the control
+ *
+ * Output:
+ *      double - The time of the slowest process on rank 0, 0 on the other ranks
+ */
+double runSampleSparse(Plan* plan, Test test, int rank, bool report) {
+    int num_procs;
+    double time=0.0;
+    long long nnz, total=0;
+    const int N=plan->N, C=plan->C;
+    Sparse A, T;
+    MPI_Comm_size(actual_comm, &num_procs);
+    createSparse(&A, plan->rows, sliceStart(N, num_procs, rank), (int)((double)plan->rows*C*options.density/100)+C);
+    initializeSparse(&A, test, N, C);
+    createSparse(&T, plan->cols, sliceStart(C, num_procs, rank), A.nnz);
+    const void* const flushed[4]={A.values, A.col_idx, T.values, T.col_idx};
+    const long long flushed_sizes[4]={A.capacity*(long long)sizeof(float), A.capacity*(long long)sizeof(int), T.capacity*(long long)sizeof(float), T.capacity*(long long)sizeof(int)};
+    flushCache(flushed, flushed_sizes, 4);
+    MPI_Barrier(actual_comm);
+    const double tw_start=MPI_Wtime();
+    bool symmetry=executionSparse(&A, &T, N, C);
+    const double elapsed=MPI_Wtime()-tw_start;
+    MPI_Reduce(&elapsed, &time, 1, MPI_DOUBLE, MPI_MAX, 0, actual_comm);
+    if(report) {
+        nnz=A.nnz;
+        MPI_Reduce(&nnz, &total, 1, MPI_LONG_LONG, MPI_SUM, 0, actual_comm);
+        if(rank==0) {
+            if (symmetry) {
+                printf("The matrix is symmetric.\n");
+            } else {
+                printf("The matrix is NOT symmetric.\n");
+            }
+            printf("Nonzeros: %lld (%.2lf%%)\n", total, 100.0*total/((double)N*C));
+            printf("Time Elapsed (get time)=%.12f\n", time);
+            if(!symmetry) {
+                controlSparse(&A, &T);
+            }
         }
     }
-    char void_element='-';
-    if(type==0) {
-        fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-15.12lf\n", lines, code, mode, dim, test, samples, scaling, num_procs, avg_time);
+    freeSparse(&A);
+    freeSparse(&T);
+    MPI_Barrier(actual_comm);
+    return time;
+}
+/*
+ * Name: runSamplePacked
+ * Runs one sample of a plan of mode MPI_DISTRIBUTED with the symmetric matrix stored packed (--packed=1): every
+ * process generates the packed rows of its slab, which by symmetry are also the ones of its slab of the transposed
+ * matrix. The check isn't needed and the transposition is the alias of transposePacked, measured as in runSample
+ * but written by runBenchmark only in FILENAMEPACKED, not with the times of the mode.
+ *
+ * Input:
+ *      plan (Plan*) - The plan created by createPlan
+ *      test (Test) - The test used to initialize the matrix
+ *      rank (int) - The rank of the current MPI process
+ *      report (bool) - If true rank 0 prints the storage, the time and the control of the transposition
+ *
+ * Output:
+ *      double - The time of the slowest process on rank 0, 0 on the other ranks
+ */
+double runSamplePacked(Plan* plan, Test test, int rank, bool report) {
+    double time=0.0;
+    const int N=plan->N;
+    const int first=rank*plan->rows;
+    const int rows=plan->rows;
+    const long long count=PACKED_OFFSET(first+rows)-PACKED_OFFSET(first);
+    float* P=createPacked(first, rows);
+    initializePacked(P, test, first, rows, N);
+    const void* const flushed[1]={P};
+    const long long flushed_sizes[1]={count*(long long)sizeof(float)};
+    flushCache(flushed, flushed_sizes, 1);
+    MPI_Barrier(actual_comm);
+    const double tw_start=MPI_Wtime();
+    const float* TP=transposePacked(P);
+    const double elapsed=MPI_Wtime()-tw_start;
+    MPI_Reduce(&elapsed, &time, 1, MPI_DOUBLE, MPI_MAX, 0, actual_comm);
+    if(rank==0 && report) {
+        printf("The matrix is symmetric (packed, %lld of %lld elements on rank 0).\n", count, (long long)N*N);
+        printf("Time Elapsed (get time)=%.12f\n", time);
+        const int i[3]={MIN(first+1, first+rows-1), first+rows/2, first+rows-1};
+        int k;
+        for (k=0; k<3; k++) {
+            printf("[%d][%d] M: %.2f T: %.2f\n", i[k], 0, packedElement(P, first, i[k], 0), packedElement(TP, first, 0, i[k]));
+        }
+    }
+    free(P);
+    MPI_Barrier(actual_comm);
+    return time;
+}
+/*
+ * Name: freePlan
+ * Frees what createPlan allocated and gives back actual_comm to the communicator the plan was created on.
+ *
+ * Input:
+ *      plan (Plan*) - The plan to free
+ *
+ * Output: none
+ */
+void freePlan(Plan* plan) {
+    freeData(&plan->sending);
+    freeData(&plan->receiving);
+    if(plan->column!=MPI_DATATYPE_NULL) {
+        MPI_Type_free(&plan->column);
+    }
+    if(plan->mode==MPI_HIER) {
+        freeHierarchy(&hierarchy);
+    }
+    MPI_Comm_free(&plan->comm);
+    actual_comm=plan->parent;
+}
+/*
+ * Name: countNodes
+ * Counts the nodes of a communicator, grouping the processes as setupHierarchy does (by shared memory, or in
+ * nodes of options.node_size consecutive ranks).
+ *
+ * Input:
+ *      comm (MPI_Comm) - The communicator
+ *
+ * Output:
+ *      int - The number of nodes, the same on every rank
+ */
+int countNodes(MPI_Comm comm) {
+    int rank, node_rank, leader, nodes;
+    MPI_Comm node_comm;
+    MPI_Comm_rank(comm, &rank);
+    if(options.node_size>0) {
+        MPI_Comm_split(comm, rank/options.node_size, rank, &node_comm);
     }
     else {
-        if(seq_time<1e-9) {
-            fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-15.12f %-15c %-10c %-10c%%\n", lines, code, mode, dim, test, samples, num_procs, scaling, avg_time, void_element, void_element, void_element);
-        }
-        else {
-            fprintf(file, "%-10d %-15s %-5d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-10.2lf %-10.2lf%%\n", lines, code, mode, dim, test, samples, num_procs, scaling, avg_time, seq_time, speedup, efficiency);
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    }
+    MPI_Comm_rank(node_comm, &node_rank);
+    leader=(node_rank==0) ? 1 : 0;
+    MPI_Allreduce(&leader, &nodes, 1, MPI_INT, MPI_SUM, comm);
+    MPI_Comm_free(&node_comm);
+    return nodes;
+}
+/*
+ * Name: lookupTuning
+ * Searches in the tuning database the best configuration measured for a matrix on a number of processes and nodes.
+ * If the same key was tuned more times, the last line wins.
+ *
+ * Input:
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *      num_procs (int) - The number of processes
+ *      nodes (int) - The number of nodes
+ *      config (int[3]) - Filled with mode, tile and exchange of the configuration found
+ *
+ * Output:
+ *      bool - True if the key is in the database
+ */
+bool lookupTuning(int N, int C, int num_procs, int nodes, int config[3]) {
+    char line[256];
+    char ftype[20];
+    int frows, fcols, fprocs, fnodes, fmode, ftile, fexchange;
+    double ftime;
+    bool found=false;
+    FILE* file=fopen(FILENAMETUNING, "r");
+    if(file==NULL) {
+        return false;
+    }
+    //An empty database (no header) has no configurations
+    if(fgets(line, sizeof(line), file)!=NULL) {
+        while(fscanf(file, "%d %d %d %d %19s %d %d %d %lf", &frows, &fcols, &fprocs, &fnodes, ftype, &fmode, &ftile, &fexchange, &ftime)==9) {
+            if(frows==N && fcols==C && fprocs==num_procs && fnodes==nodes && strcmp(ftype, ELEMENT_TYPE)==0) {
+                config[0]=fmode;
+                config[1]=ftile;
+                config[2]=fexchange;
+                found=true;
+            }
         }
     }
     fclose(file);
+    return found;
 }
 /*
- *  Name: inputParameters
- *  Function that checks the number of arguments passed to the program (7 ok, less exits or more).
- *  Input:
- *      argc (int) - The number of arguments passed to the program.
- *  Output: none
+ * Name: storeTuning
+ * Appends to the tuning database the best configuration measured for a matrix on a number of processes and nodes.
+ *
+ * Input:
+ *      N (int) - The number of rows of the matrix
+ *      C (int) - The number of columns of the matrix
+ *      num_procs (int) - The number of processes
+ *      nodes (int) - The number of nodes
+ *      config (int[3]) - Mode, tile and exchange of the configuration
+ *      time (double) - The median time of the configuration
+ *
+ * Output: none
  */
-void inputParameters(int argc) {
-    printf("%d\n\n\n", argc);
-    if(argc!=7) {
-        fprintf(stderr, "Invalid parameters. They are:\n\n(1) Code identifying the compilation (everything is acceptable, default one is SO0, is used as reference for sequential code -O0 and will be used as comparison for speedup and efficiency)\n\n(2)Integer for mode. The modes are:\n1. Sequential Code\n2. MPI Parallelism All Gather\n3. MPI Parallelism using Row Major\n\n(3) Exponential of 2 from 4 to 12 (16->4, 64->6, 1024->10, 4096->12)\n\n(4) Testing:\n0. Matrix is generated randomly\n1. A default test matrix is generated according to an algorithm (used for testing, with one interaction in checkSym and Transposition)\n2. A default test symmetric matrix (only checkSym works)\n3. The worst case scenario with a matrix, with only one element different not on main diagonal\n\n(5) Number of samples (>=25)\n\n(6) Scaling Type:\n0. Strong Scaling (Size inputed partitioned of job among processes)\n1. Weak Scaling (Size inputed assigned to every process)\n\n");
-        exit(1);
+void storeTuning(int N, int C, int num_procs, int nodes, int config[3], double time) {
+    FILE* file=fopen(FILENAMETUNING, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMETUNING);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-10s %-10s %-10s %-10s %-10s %-5s %-10s %-10s %-15s\n", "Rows", "Cols", "N Procs", "Nodes", "Type", "Mode", "Tile", "Exchange", "Time(s)");
     }
+    fprintf(file, "%-10d %-10d %-10d %-10d %-10s %-5d %-10d %-10d %-15.12lf\n", N, C, num_procs, nodes, ELEMENT_TYPE, config[0], config[1], config[2], time);
+    fclose(file);
 }
 /*
- *  Name: valueInputed
- *  Function that processes and validates the input values based on the argument provided. It checks if the input values are within valid ranges for different parameters (mode, dimension, test, samples, and number of threads). If any value is invalid, it prints an error message and exits the program.
- *  Input:
- *      argc (int) - The number of command-line arguments passed to the program
- *      argv (const char*) - A string representing the argument value to be process
- *      value (int) - The specific value identifying which input parameter is being validated (2. mode, 3. dimension, 4. test, 5. samples, 6. scaling)
- *  Output:
- *      returnValue (int) - The validated integer value for the corresponding parameter
+ * Name: autotune
+ * Creates the plan of the best configuration for a matrix on a communicator. The best configuration of the key
+ * (N, C, processes, nodes, type of the elements) is read from the tuning database; if it's missing, every candidate
+ * runs TUNING_SAMPLES samples on the static test and the one with the lowest median time is stored in the database.
+ * The candidates are MPI_ALL with the tiles 0 (untiled), 16, 32 and 64 of the local transposition, MPI_BLOCK_OPT
+ * (its block is transposed by the packing, not by the tiles), MPI_EXCHANGE with each schedule and MPI_HIER; the
+ * configurations that can't run on the communicator are skipped.
+ * MPI_BLOCK isn't a candidate because it exchanges an element per message and is always dominated by MPI_BLOCK_OPT.
+ *
+ * Input:
+ *      plan (Plan*) - The plan to create with the best configuration
+ *      comm (MPI_Comm) - The communicator of the processes
+ *      N (int) - The number of rows of the matrix (N x C), in weak scaling the rows of all the processes
+ *      C (int) - The number of columns of the matrix
+ *      rank (int) - The rank of the current MPI process
+ *
+ * Output:
+ *      bool - True if the plan was created, false if no candidate can run on the communicator
  */
-int valueInputed(int argc, const char* argv, int value) {
-    int returnValue=-1;
-    if(value>=2 && value<=6) {
-        switch (value) {
-            case 2: {
-               returnValue=atoi(argv);
-                if (returnValue<=START || returnValue>=END) {
-                    fprintf(stderr, "1. Sequential Code\n2. MPI Parallelism All Gather\n3. MPI Parallelism using Row Major\n\n");
-                    exit(1);
+bool autotune(Plan* plan, MPI_Comm comm, int N, int C, int rank) {
+    const Mode modes[4]={MPI_ALL, MPI_BLOCK_OPT, MPI_EXCHANGE, MPI_HIER};
+    const int tiles[4]={0, 16, 32, 64};
+    const char* names[EXCHANGES]={"alltoall", "pairwise", "bruck", "eklundh", "overlap"};
+    int num_procs, m, t, e, s;
+    MPI_Comm_size(comm, &num_procs);
+    const int nodes=countNodes(comm);
+    //Found flag, mode, tile and exchange of the best configuration
+    int best[4]={0, 0, 0, PAIRWISE};
+    double best_time=0.0;
+    if(rank==0) {
+        best[0]=lookupTuning(N, C, num_procs, nodes, &best[1]) ? 1 : 0;
+    }
+    MPI_Bcast(best, 4, MPI_INT, 0, comm);
+    const bool cached=(best[0]==1);
+    if(!cached) {
+        for (m=0; m<4; m++) {
+            //The block of MPI_BLOCK_OPT is transposed by the packing, not by the tiled kernels
+            const int n_tiles=(modes[m]==MPI_ALL) ? 4 : 1;
+            const int n_exchanges=(modes[m]==MPI_EXCHANGE) ? EXCHANGES : 1;
+            for (t=0; t<n_tiles; t++) {
+                for (e=0; e<n_exchanges; e++) {
+                    const Exchange exchange=(modes[m]==MPI_EXCHANGE) ? (Exchange)e : PAIRWISE;
+                    Plan candidate;
+                    double times[TUNING_SAMPLES];
+                    if(!createPlan(&candidate, comm, modes[m], exchange, tiles[t], N, C, 1)) {
+                        continue;
+                    }
+                    for (s=0; s<options.warmup; s++) {
+                        runSample(&candidate, STATIC, rank, false);
+                    }
+                    for (s=0; s<TUNING_SAMPLES; s++) {
+                        times[s]=runSample(&candidate, STATIC, rank, false);
+                    }
+                    freePlan(&candidate);
+                    if(rank==0) {
+                        qsort(times, TUNING_SAMPLES, sizeof(double), compareDoubles);
+                        const double median=times[TUNING_SAMPLES/2];
+                        printf("Tuning mode %d tile %d exchange %s: %.12f secs\n", modes[m], tiles[t], names[exchange], median);
+                        if(best[0]==0 || median<best_time) {
+                            best[0]=1;
+                            best[1]=modes[m];
+                            best[2]=tiles[t];
+                            best[3]=exchange;
+                            best_time=median;
+                        }
+                    }
                 }
             }
-            break;
-            case 3: {
-                returnValue=pow(2, atoi(argv));
-                if (returnValue<MIN_SIZE || returnValue>MAX_SIZE) {
-                    fprintf(stderr, "Invalid dimension, it has to be a power of 2 between 4 and 12. Insert the exponential\n\n");
-                    exit(1);
-                }
+        }
+        MPI_Bcast(best, 4, MPI_INT, 0, comm);
+        if(best[0]==0) {
+            return false;
+        }
+        if(rank==0) {
+            storeTuning(N, C, num_procs, nodes, &best[1], best_time);
+        }
+    }
+    if(rank==0) {
+        printf("%s configuration for %dx%d on %d processes and %d nodes: mode %d tile %d exchange %s\n", cached ? "Cached" : "Tuned", N, C, num_procs, nodes, best[1], best[2], names[best[3]]);
+    }
+    return createPlan(plan, comm, (Mode)best[1], (Exchange)best[3], best[2], N, C, 1);
+}
+/*
+ * Name: runBenchmark
+ * Measures a configuration on the processes of actual_comm: creates its plan (or autotunes it), runs the warm-up
+ * and the samples until they are enough (or precise enough with --precision), and writes the times, the average,
+ * the statistics, the phases, the counters and the bandwidth as a single run of the program does.
+ * It has to be called by all the processes of actual_comm.
+ *
+ * Input:
+ *      code (const char*) - A string representing the code identifier
+ *      mode (const Mode) - The execution mode
+ *      N (int) - The number of rows of the matrix (of each process in weak scaling)
+ *      C (int) - The number of columns of the matrix
+ *      test (const int) - The test type used for matrix generation
+ *      samples (const int) - The number of samples
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      over (const int) - The processes dropped because they exceeded N, counted in the files as in the launch
+ *      rank (int) - The rank of the current process in actual_comm
+ *
+ * Output: none
+ */
+void runBenchmark(const char* code, const Mode mode, int N, int C, const int test, const int samples, const int scaling, const int over, int rank) {
+    int num_procs, count=0;
+    double time=0.0;
+    MPI_Comm_size(actual_comm, &num_procs);
+    const int batch=(mode==MPI_BATCH) ? options.batch : 1;//Matrices transposed together
+    //Rows of the global matrix, in weak scaling each process has its own N x C
+    const int NR=(scaling==1) ? N*num_procs : N;
+    //With --precision the sampling goes on after samples until the median is precise enough
+    const int max_samples_run=(options.precision>0.0) ? MAX(samples, options.max_samples) : samples;
+    if(mode==MPI_BATCH && scaling!=0) {
+        if(rank==0) {
+            printf("The batch mode works only in strong scaling with a number of processes %d dividing N=%d\n", num_procs, N);
+        }
+        return;
+    }
+    Plan plan;
+    if(mode==MPI_AUTO) {
+        if(!autotune(&plan, actual_comm, NR, C, rank)) {
+            if(rank==0) {
+                printf("No configuration can run on %d processes with the matrix %dx%d\n", num_procs, NR, C);
             }
-            break;
-            case 4: {
-                returnValue=atoi(argv);
-                if(returnValue>2 || returnValue<0) {
-                    fprintf(stderr, "Invalid testing, it has to be:\n\n0. (Random)\n1. (Standard Test No Symmetric)\n2. (Standard Test Symmetric)\n\n");
-                    exit(1);
-                }
+            return;
+        }
+    }
+    else {
+        if(!createPlan(&plan, actual_comm, mode, options.exchange, options.tile, NR, C, batch)) {
+            return;
+        }
+    }
+    //The packed symmetric matrix is only aliased, its times aren't the ones of a transposition of the mode
+    const bool packed=usePacked(plan.mode, (Test)test, NR, C);
+    //The two packings of MPI_BLOCK_OPT write the same rows, the datatype one is told apart in all the files by its code
+    char tagged[20];
+    snprintf(tagged, sizeof(tagged), "%s%s", code, (plan.mode==MPI_BLOCK_OPT && options.pack==PACK_DATATYPE) ? PACK_DATATYPE_TAG : "");
+    code=tagged;
+    double* results=(double*)malloc(sizeof(double)*max_samples_run);
+    double* sorted=(double*)malloc(sizeof(double)*max_samples_run);
+    if (results==NULL || sorted==NULL) {
+        fprintf(stderr, "ERROR Memory Allocation");
+        MPI_Finalize();
+        exit(1);
+    }
+    memset(&compression_stats, 0, sizeof(CompressionStats));
+    printf("%d/%d\t", rank, num_procs);
+    //Warm-up Phase, the samples are discarded
+    int i;
+    for (i=0; i<options.warmup; i++) {
+        runSample(&plan, test, rank, false);
+    }
+    //The phases and the counters are measured only on the samples
+    memset(&phase_times, 0, sizeof(PhaseTimes));
+    memset(&overlap_stats, 0, sizeof(OverlapStats));
+    memset(counters.total, 0, sizeof(counters.total));
+    //Sampling Phase
+    Statistics stats;
+    int sampling=1;
+    while (sampling) {
+        time=runSample(&plan, test, rank, true);
+        if(rank==0) {
+            if(batch>1) {
+                //Time of the batch amortized on each matrix, to be comparable with the other modes
+                printf("Batch of %d matrices - Throughput %.2f matrices/s\n", batch, batch/time);
+                time=time/batch;
             }
-            break;
-            case 5: {
-                returnValue=atoi(argv);
-                if(returnValue<MIN_SAMPLES) {
-                    fprintf(stderr, "Invalid samples number, it has to be at least of 25\n\n");
-                    exit(1);
-                }
+            if(!packed) {
+                openFilesResultsPerMode(code, mode, N, C, test, samples, num_procs, scaling, time);
             }
-            break;
-            case 6:
-                returnValue=atoi(argv);
-                if(returnValue!=0 && returnValue!=1) {
-                    fprintf(stderr, "Scaling Type:\n0. Strong Scaling (Size inputed partitioned of job among processes)\n1. Weak Scaling (Size inputed assigned to every process)\n\n");
-                    exit(1);
+            results[count]=time;
+        }
+        count++;
+        if(rank==0) {
+            sampling=(count<samples) ? 1 : 0;
+            if(!sampling && options.precision>0.0 && count<max_samples_run) {
+                memcpy(sorted, results, sizeof(double)*count);
+                computeStatistics(sorted, count, &stats);
+                sampling=((stats.ci_high-stats.ci_low)/2>options.precision*stats.median) ? 1 : 0;
+            }
+        }
+        MPI_Bcast(&sampling, 1, MPI_INT, 0, actual_comm);
+    }
+    //Exit sampling and compute average
+    reportCompression(code, mode, N, num_procs, rank);
+    reportOverlap(code, mode, N, num_procs, scaling, rank);
+    reportPhases(code, mode, N, num_procs, scaling, count, rank);
+    reportCounters(code, mode, N, num_procs, scaling, count, rank);
+    freePlan(&plan);
+    if(rank==0) {
+        computeStatistics(results, count, &stats);
+        printf("\n\nFINAL RESULTS WITH:\nMODE %d\nDimension: %dx%d\nTesting: %d\nSamples: %d (warm-up %d)\nThreads: %d\nCache: %s\nMedian Time: %.12lf secs\n", mode, N, C, test, count, options.warmup, num_procs+over, (options.cache==CACHE_WARM) ? "warm" : (options.cache==CACHE_CLFLUSH) ? "cold (clflush)" : "cold", stats.median);
+        if(scaling==1) {
+            //The dimension written in the files is the one of each process, as the efficiency of weak scaling assumes
+            printf("Global Dimension: %dx%d (%dx%d per process)\n", NR, C, N, C);
+        }
+        if(mode==MPI_SPARSE) {
+            printf("Density: %.4lf%%\n", options.density);
+        }
+        printf("Affinity: %s\n", affinityName(options.affinity));
+        if(plan.mode==SEQ || plan.mode==MPI_ALL || plan.mode==MPI_BLOCK || plan.mode==MPI_BATCH) {
+            //Kernel of the local transposition of the matrix of the rank 0
+            char kernel[64];
+            describeKernel(plan.rows, plan.cols, plan.tile, kernel, sizeof(kernel));
+            printf("Kernel: %s\n", kernel);
+        }
+        if(plan.mode==MPI_BLOCK_OPT) {
+            printf("Pack: %s\n", (options.pack==PACK_DATATYPE) ? "derived datatype" : "manual");
+        }
+        if(options.packed==1) {
+            printf("Storage: %s\n", packed ? "packed lower triangle" : "full (packed only for the symmetric test 2 of a square matrix)");
+        }
+        printf("Mean Time: %.12lf secs\nPercentiles 5/25/75/95: %.12lf %.12lf %.12lf %.12lf secs\nMAD: %.12lf secs\nConfidence Interval 95%% of the median: [%.12lf, %.12lf] secs (+-%.2lf%%)\nOutliers: %d\n\n", stats.mean, stats.p5, stats.p25, stats.p75, stats.p95, stats.mad, stats.ci_low, stats.ci_high, (stats.ci_high-stats.ci_low)/2/stats.median*100, stats.outliers);
+        if(options.precision>0.0 && (stats.ci_high-stats.ci_low)/2>options.precision*stats.median) {
+            printf("The confidence interval didn't reach the precision %.2lf%% in %d samples\n", options.precision*100, count);
+        }
+        if(packed) {
+            writePacked(code, mode, N, test, num_procs+over, scaling, &stats, PACKED_OFFSET(NR)*sizeof(float));
+            free(results);
+            free(sorted);
+            return;
+        }
+        openFilesAvgPerMode(code, mode, N, C, test, count, num_procs+over, scaling, stats.median);
+        //The rows of the samples and of the average are written together at the end of the run
+        flushResults();
+        writeStatistics(code, mode, N, C, test, num_procs+over, scaling, &stats);
+        //A transposition reads and writes the whole matrix once, the baseline is the one of the processes used
+        //The sparse mode moves only the nonzeros, as triplets
+        const double bytes=(mode==MPI_SPARSE) ? 2.0*NR*C*options.density/100*sizeof(Triplet) : 2.0*NR*C*sizeof(float);
+        reportBandwidth(code, mode, N, num_procs, scaling, bytes, stats.median);
+    }
+    free(results);
+    free(sorted);
+}
+/*
+ * Name: runSweep
+ * Runs in a single launch the campaign given by --sizes, --modes, --tests and --procs. For each number of
+ * processes (in increasing order, so the runs on 1 process give the sequential times to the following ones) the
+ * first ranks of MPI_COMM_WORLD are split in a communicator, which becomes actual_comm, and measure every size,
+ * mode and test with runBenchmark, writing the same files of the single runs; the other ranks wait at a barrier.
+ * The sequential mode runs only on 1 process and the configurations with more processes than rows are skipped; the
+ * modes that can't split the rows among the processes are rejected by createPlan and the sweep goes on.
+ * It has to be called by all the processes of MPI_COMM_WORLD.
+ *
+ * Input:
+ *      code (const char*) - A string representing the code identifier
+ *      N (int) - The dimension given by (3), used when --sizes is missing
+ *      test (int) - The test given by (4), used when --tests is missing
+ *      samples (const int) - The number of samples of each configuration
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      rank (int) - The rank of the current process in MPI_COMM_WORLD
+ *
+ * Output: none
+ */
+void runSweep(const char* code, int N, int test, const int samples, const int scaling, int rank) {
+    int world_size, p, e, m, t, configurations=0;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    if(options.sweep_sizes.count==0) {
+        options.sweep_sizes.values[options.sweep_sizes.count++]=(int)round(log2(N));
+    }
+    if(options.sweep_tests.count==0) {
+        options.sweep_tests.values[options.sweep_tests.count++]=test;
+    }
+    if(options.sweep_procs.count==0) {
+        for (p=1; p<=world_size; p*=2) {
+            options.sweep_procs.values[options.sweep_procs.count++]=p;
+        }
+    }
+    qsort(options.sweep_procs.values, options.sweep_procs.count, sizeof(int), compareInts);
+    const double start=MPI_Wtime();
+    for (p=0; p<options.sweep_procs.count; p++) {
+        const int procs=options.sweep_procs.values[p];
+        if(procs>world_size) {
+            if(rank==0) {
+                printf("Sweep: skip %d processes, the launch has only %d\n", procs, world_size);
+            }
+            continue;
+        }
+        MPI_Comm sub;
+        MPI_Comm_split(MPI_COMM_WORLD, (rank<procs) ? 0 : MPI_UNDEFINED, rank, &sub);
+        if(sub!=MPI_COMM_NULL) {
+            //The flush buffer covers the part of the caches of the processes of the node that are running
+            freeCache();
+            setupCache(sub);
+            actual_comm=sub;
+            for (e=0; e<options.sweep_sizes.count; e++) {
+                const int n=(int)pow(2, options.sweep_sizes.values[e]);
+                for (m=0; m<options.sweep_modes.count; m++) {
+                    const Mode mode=(Mode)options.sweep_modes.values[m];
+                    if((mode==SEQ && procs!=1) || procs>n) {
+                        continue;
+                    }
+                    for (t=0; t<options.sweep_tests.count; t++) {
+                        if(rank==0) {
+                            printf("\nSweep: mode %d, dimension %dx%d, test %d, %d processes\n", mode, n, n, options.sweep_tests.values[t], procs);
+                        }
+                        runBenchmark(code, mode, n, n, options.sweep_tests.values[t], samples, scaling, 0, rank);
+                        configurations++;
+                    }
                 }
-            break;
-            default:
-                exit(1);
-                break;
+            }
+            MPI_Comm_free(&sub);
+            actual_comm=MPI_COMM_WORLD;
         }
+        MPI_Barrier(MPI_COMM_WORLD);
     }
-    return returnValue;
+    if(rank==0) {
+        printf("\nSweep: %d configurations in %.3lf s\n", configurations, MPI_Wtime()-start);
+    }
+}
+/*
+ * Name: streamClock
+ * Monotonic clock of the stream, read also by the producer thread, that doesn't call MPI.
+ *
+ * Input: none
+ * Output: double - The time in seconds
+ */
+double streamClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec+now.tv_nsec*1e-9;
 }
 /*
- *  Name: initializeMatrix
- *  Function that initializes a matrix based on test. Elements are populated with either random values, static values, or predefined values for symmetric or worst-case test scenarios.
- *  Input:
- *      M (float**) - The matrix to be initialized. This matrix will be filled with values based on the selected test type
- *      test (Test) - The test type that determines how the matrix will be initialized. It can be RANDOM, STATIC, SYM, or WORST (0, 1, 2, 3)
- *      n (int) - Size of Matrix
- *  Output: none
+ * Name: produceStream
+ * Body of the producer thread of rank 0, the stand-in of the source of the stream: writes the matrices one after
+ * the other in the free slots of the ring, reading them from the source (N*C raw floats each) or generating them
+ * with the test, marks their arrival and wakes up rank 0. It waits while the ring is full, and ends when all the
+ * matrices are produced or the source ends.
+ *
+ * Input:
+ *      arg (void*) - The Stream
+ *
+ * Output: void* - NULL
  */
-void initializeMatrix(float** M, Test test, int x, int y) {
-    if(test==STATIC) {
-        srand(38);
-    }
-    else {
-        if (test==RANDOM) {
-            srand((unsigned)time(NULL));
+void* produceStream(void* arg) {
+    Stream* stream=(Stream*)arg;
+    const size_t count=(size_t)stream->N*stream->C;
+    int k;
+    for (k=0; k<stream->total; k++) {
+        pthread_mutex_lock(&stream->lock);
+        while (k-stream->consumed>=STREAM_SLOTS) {
+            pthread_cond_wait(&stream->freed, &stream->lock);
         }
-    }
-    int i, j;
-    for (i=0; i<x; i++) {
-        for (j=0; j<y; j++) {
-            switch (test) {
-                case RANDOM: M[i][j]=random_float2(0, 9999); break;
-                case STATIC:
-                    M[i][j]=random_float2(0, 9999); break;
-                    //M[i][j]=i*1.0/200000*n+j*1.0/100+1; break;
-                case SYM: M[i][j]=5.0; break;
-                default: fprintf(stderr, "Unexpected Error\n"); exit(1);
+        pthread_mutex_unlock(&stream->lock);
+        float** slot=stream->ring[k%STREAM_SLOTS];
+        if(stream->source!=NULL) {
+            if(fread(&(slot[0][0]), sizeof(float), count, stream->source)!=count) {
+                break;
             }
         }
+        else {
+            initializeMatrix(slot, stream->test, 0, stream->N, stream->N, stream->C);
+        }
+        pthread_mutex_lock(&stream->lock);
+        stream->arrival[k]=streamClock();
+        stream->produced=k+1;
+        pthread_cond_signal(&stream->filled);
+        pthread_mutex_unlock(&stream->lock);
     }
+    pthread_mutex_lock(&stream->lock);
+    stream->ended=1;
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
 }
 /*
- * Name: executionProgram
- * Executes the program based on the given mode, and performs matrix transposition using different MPI strategies.
- * This function checks if the matrix is symmetric and, if not, performs the transposition using different strategies.
+ * Name: runStream
+ * Streaming mode: a continuous stream of matrices arriving on rank 0 in a ring of STREAM_SLOTS matrices, written by
+ * a producer thread (see produceStream) from the file or pipe given by --stream or generated with the test, is
+ * transposed by a pipeline of three stages kept in flight together: at step s the scatter of the matrix s
+ * (MPI_Iscatter), the gather of the matrix s-2 (MPI_Igather) and the local transposition of the matrix s-1. The
+ * slabs of the processes, the types of the scatter and of the gather and the transposed matrices of rank 0 are
+ * created once for the whole stream. The latency of a matrix goes from its arrival in the ring to the end of its
+ * gather; after the --warmup matrices, the samples matrices give the sustained throughput and the percentiles of
+ * the latency, printed and appended in FILENAMESTREAM, while the latencies are written as the times of the
+ * samples of the mode. The last matrix is controlled as in the other modes. It works with the rows divided among
+ * the processes and has to be called by all the processes of actual_comm.
  *
  * Input:
- *      MGEN (float**) - The generated matrix, typically the global matrix to check symmetry against.
- *      M (float**) - The local matrix for the current MPI rank.
- *      T (float**) - The matrix where the transposed result is stored.
- *      TGEN (float**) - The matrix to store the generated transposed result.
- *      tempM (float**) - A temporary matrix used for optimized block transposition.
- *      mode (Mode) - The execution mode (SEQ, MPI_ALL, MPI_BLOCK, or MPI_BLOCK_OPT).
- *      N (int) - The size of the matrix (N x N).
- *      rows (int) - The number of rows assigned to the current rank.
- *      rank (int) - The MPI rank of the current process.
- *      scaling (int) - Scaling mode defining 0. Strong 1. Weak.
- *      sending (DataCommunicate) - Structure containing the sending data for MPI operations.
- *      receiving (DataCommunicate) - Structure containing the receiving data for MPI operations.
- *      sender_mpi_all (Communicator2D) - The MPI communicator for the 2D process grid.
+ *      code (const char*) - A string representing the code identifier
+ *      N (int) - The number of rows of the matrix (of each process in weak scaling)
+ *      C (int) - The number of columns of the matrix
+ *      test (const int) - The test used by the producer stand-in
+ *      samples (const int) - The number of matrices measured
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      over (const int) - The processes dropped because they exceeded N, counted in the files as in the launch
+ *      rank (int) - The rank of the current process in actual_comm
  *
- * Output:
- *      bool - True if the matrix is symmetric and no transposition was needed, false if the matrix was not symmetric
- *   and the transposition was performed.
+ * Output: none
  */
-
-bool executionProgram(float** MGEN, float** M, float** T, float** TGEN, float** tempM, Mode mode, int N, int rows, int rank, int scaling, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender_mpi_all) {
-    switch (mode) {
-        case SEQ:
-        case MPI_ALL: {
-            if(!checkSymMPI(MGEN, N, rank, rows, scaling)) {
-                matTransposeMPIAllGather(MGEN, M, T, TGEN, rank, N, rows, scaling, sending, receiving, sender_mpi_all);
-                return false;
+void runStream(const char* code, int N, int C, const int test, const int samples, const int scaling, const int over, int rank) {
+    int num_procs, k, s, ok=1;
+    MPI_Comm_size(actual_comm, &num_procs);
+    const int NR=(scaling==1) ? N*num_procs : N;
+    if(NR%num_procs!=0) {
+        if(rank==0) {
+            printf("The streaming mode works only with a number of processes %d dividing N=%d\n", num_procs, NR);
+        }
+        return;
+    }
+    const int rows=NR/num_procs;
+    Stream stream;
+    memset(&stream, 0, sizeof(Stream));
+    stream.total=options.warmup+samples;
+    stream.test=(Test)test;
+    stream.N=NR;
+    stream.C=C;
+    if(rank==0 && options.stream!=NULL) {
+        stream.source=fopen(options.stream, "rb");
+        if(stream.source==NULL) {
+            printf("Couldn't open the stream %s\n", options.stream);
+            ok=0;
+        }
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, actual_comm);
+    if(!ok) {
+        return;
+    }
+    //Types of the slab of rows scattered and of the transposed slab gathered in its columns, for the whole stream
+    Communicator2D scatter, gather;
+    setupBatchCommunicators(&scatter, &gather, 1, NR, C, rows);
+    commitCommunicator(&scatter);
+    commitCommunicator(&gather);
+    //Kernel of the local transposition picked once for the whole stream, as createPlan does for the other modes
+    const TransposeKernel kernel=selectKernel(rows, C, (options.tile<0) ? defaultTile(rows, C) : options.tile);
+    float** slabs[STREAM_STAGES];
+    float** transposed[STREAM_STAGES];
+    MPI_Request scatters[STREAM_STAGES], gathers[STREAM_STAGES];
+    for (k=0; k<STREAM_STAGES; k++) {
+        create2DFloatMatrix(&slabs[k], rows, C);
+        create2DFloatMatrix(&transposed[k], C, rows);
+        scatters[k]=MPI_REQUEST_NULL;
+        gathers[k]=MPI_REQUEST_NULL;
+    }
+    float** results[STREAM_SLOTS]={NULL};
+    double* latencies=NULL;
+    pthread_t producer;
+    if(rank==0) {
+        for (k=0; k<STREAM_SLOTS; k++) {
+            create2DFloatMatrix(&stream.ring[k], NR, C);
+            create2DFloatMatrix(&results[k], C, NR);
+        }
+        stream.arrival=(double*)malloc(sizeof(double)*stream.total);
+        latencies=(double*)malloc(sizeof(double)*stream.total);
+        if(stream.arrival==NULL || latencies==NULL) {
+            printf("Memory allocation failed\n");
+            MPI_Finalize();
+            exit(1);
+        }
+        pthread_mutex_init(&stream.lock, NULL);
+        pthread_cond_init(&stream.filled, NULL);
+        pthread_cond_init(&stream.freed, NULL);
+        if(pthread_create(&producer, NULL, produceStream, &stream)!=0) {
+            printf("The producer thread couldn't be started\n");
+            MPI_Finalize();
+            exit(1);
+        }
+    }
+    //Matrices of the stream, fewer if the source ends before
+    int count=stream.total;
+    double start=streamClock(), end=start;
+    for (s=0; s-3<count; s++) {
+        //1. The gather of the matrix s-3 posted at the previous step is waited, the matrix is done
+        const int done=s-3;
+        if(done>=0) {
+            MPI_Wait(&gathers[done%STREAM_STAGES], MPI_STATUS_IGNORE);
+            if(rank==0) {
+                end=streamClock();
+                latencies[done]=end-stream.arrival[done];
+                if(done==options.warmup-1) {
+                    start=end;
+                }
             }
         }
-        break;
-        case MPI_BLOCK: {
-            if(!checkSymMPI(MGEN, N, rank, N/(sending.nprocs_x*sending.nprocs_y), scaling)) {
-                matTransposeMPIBlock(MGEN, M, T, TGEN, rank, N, rows, sending, receiving);
-                return false;
+        //2. Scatter of the matrix s, as soon as it arrives in the ring
+        if(s<count) {
+            int available=1;
+            if(rank==0) {
+                pthread_mutex_lock(&stream.lock);
+                while (stream.produced<=s && !stream.ended) {
+                    pthread_cond_wait(&stream.filled, &stream.lock);
+                }
+                available=(stream.produced>s) ? 1 : 0;
+                pthread_mutex_unlock(&stream.lock);
+            }
+            if(options.stream!=NULL) {
+                //Only a file or a pipe can end before, the matrices generated are always all there
+                MPI_Bcast(&available, 1, MPI_INT, 0, actual_comm);
+            }
+            if(available) {
+                MPI_Iscatter((rank==0) ? &(stream.ring[s%STREAM_SLOTS][0][0]) : NULL, 1, scatter.resized_type, &(slabs[s%STREAM_STAGES][0][0]), rows*C, MPI_FLOAT, 0, actual_comm, &scatters[s%STREAM_STAGES]);
+            }
+            else {
+                count=s;
             }
         }
-        case MPI_BLOCK_OPT: {
-            if(!checkSymMPI(MGEN, N, rank, N/(sending.nprocs_x*sending.nprocs_y), scaling)) {
-                matTransposeMPIBlockOPT(MGEN, M, T, TGEN, tempM, rank, N, rows, sending, receiving);
-                return false;
+        //3. Gather of the matrix s-2, transposed at the previous step
+        if(s-2>=0 && s-2<count) {
+            MPI_Igather(&(transposed[(s-2)%STREAM_STAGES][0][0]), C*rows, MPI_FLOAT, (rank==0) ? &(results[(s-2)%STREAM_SLOTS][0][0]) : NULL, 1, gather.resized_type, 0, actual_comm, &gathers[(s-2)%STREAM_STAGES]);
+        }
+        //4. Local transposition of the matrix s-1, while the other two stages are in flight
+        if(s-1>=0 && s-1<count) {
+            MPI_Wait(&scatters[(s-1)%STREAM_STAGES], MPI_STATUS_IGNORE);
+            if(rank==0) {
+                //The slot of the matrix s-1 has been sent, the producer can write the next one
+                pthread_mutex_lock(&stream.lock);
+                stream.consumed=s;
+                pthread_cond_signal(&stream.freed);
+                pthread_mutex_unlock(&stream.lock);
             }
+            matTranspose(slabs[(s-1)%STREAM_STAGES], transposed[(s-1)%STREAM_STAGES], rows, C, kernel);
         }
-        break;
-        default:
-            MPI_Finalize();
-            exit(1);
-            break;
     }
-    //freeMemory(T, N);
-    //freeMemory(TLM, rows);
-    TGEN=MGEN;
-    return true;
+    if(rank==0) {
+        pthread_join(producer, NULL);
+        const int measured=count-options.warmup;
+        if(measured<=0) {
+            printf("The stream ended after %d matrices, within the warm-up\n", count);
+        }
+        else {
+            double* sorted=&latencies[options.warmup];
+            const double throughput=measured/(end-start);
+            Statistics stats;
+            for (k=0; k<measured; k++) {
+                openFilesResultsPerMode(code, MPI_STREAM, N, C, test, measured, num_procs+over, scaling, sorted[k]);
+            }
+            computeStatistics(sorted, measured, &stats);
+            const double p99=percentile(sorted, measured, 0.99);
+            printf("\n\nFINAL RESULTS WITH:\nMODE %d\nDimension: %dx%d\nTesting: %d\nStream: %s\nMatrices: %d (warm-up %d)\nThreads: %d\nThroughput: %.2lf matrices/s\nLatency Median/95/99/Max: %.12lf %.12lf %.12lf %.12lf secs\n\n", MPI_STREAM, NR, C, test, (options.stream!=NULL) ? options.stream : "producer stand-in", measured, options.warmup, num_procs+over, throughput, stats.median, stats.p95, p99, sorted[measured-1]);
+            control(stream.ring[(count-1)%STREAM_SLOTS], results[(count-1)%STREAM_SLOTS], NR, C);
+            FILE* file=fopen(FILENAMESTREAM, "a+");
+            if(file==NULL) {
+                fprintf(stderr, "Couldn't open or create %s\n", FILENAMESTREAM);
+                exit(1);
+            }
+            fseek(file, 0, SEEK_END);
+            if(ftell(file)==0) {
+                fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-15s %-15s %-15s %-15s %-15s\n", "Compile", "Mode", "Dimension", "N Procs", "Scaling", "Matrices", "Throughput", "Median(s)", "P95(s)", "P99(s)", "Max(s)");
+            }
+            fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-15.3lf %-15.12lf %-15.12lf %-15.12lf %-15.12lf\n", code, MPI_STREAM, N, num_procs+over, scaling, measured, throughput, stats.median, stats.p95, p99, sorted[measured-1]);
+            fclose(file);
+            openFilesAvgPerMode(code, MPI_STREAM, N, C, test, measured, num_procs+over, scaling, stats.median);
+            flushResults();
+            writeStatistics(code, MPI_STREAM, N, C, test, num_procs+over, scaling, &stats);
+            //A matrix read and written every 1/throughput seconds
+            reportBandwidth(code, MPI_STREAM, N, num_procs, scaling, 2.0*NR*C*sizeof(float), 1.0/throughput);
+        }
+        if(stream.source!=NULL) {
+            fclose(stream.source);
+        }
+        pthread_mutex_destroy(&stream.lock);
+        pthread_cond_destroy(&stream.filled);
+        pthread_cond_destroy(&stream.freed);
+        for (k=0; k<STREAM_SLOTS; k++) {
+            free2DMemory(&stream.ring[k]);
+            free2DMemory(&results[k]);
+        }
+        free(stream.arrival);
+        free(latencies);
+    }
+    for (k=0; k<STREAM_STAGES; k++) {
+        free2DMemory(&slabs[k]);
+        free2DMemory(&transposed[k]);
+    }
+    freeCommunicator(&scatter);
+    freeCommunicator(&gather);
 }
 /*
  *  Name: openFilesAvgPerMode
@@ -955,44 +5480,98 @@ bool executionProgram(float** MGEN, float** M, float** T, float** TGEN, float**
  *  Input:
  *      code (const char*) - A string representing the code identifier
  *      mode (const int) - The execution mode that determines which file will be opened and written to
- *      n (const int) - The dimension of the matrix (number of rows/columns)
+ *      n (const int) - The dimension of the matrix (number of rows)
+ *      c (int) - The number of columns of the matrix
  *      test (const int) - Test for data in matrix
  *      samples (const int) - The number of samples.
  *      num_procs (const int) - The number of threads
  *      scaling (int) - Scaling mode defining 0. Strong 1. Weak
  *      avg_time (const double) - The average time taken
  */
-void openFilesAvgPerMode(const char* code, const int mode, int n, const int test, const int samples, const int num_procs, const int scaling, const double avg_time) {
-    /*if(scaling==1) {
-        n=n/num_procs;
-    }*/
-    openFile(FILENAMEGEN, code, mode, n, test, samples, num_procs, scaling, avg_time, 1);
+void openFilesAvgPerMode(const char* code, const int mode, int n, int c, const int test, const int samples, const int num_procs, const int scaling, const double avg_time) {
+    openFile(FILENAMEGEN, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
     switch (mode) {
         case SEQ:
-            openFile(FILENAMESEQ, code, mode, n, test, samples, num_procs, scaling, avg_time, 1);
+            openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
             break;
         case MPI_ALL:
             if (num_procs!=1) {
-                openFile(FILENAMEMPIALL, code, mode, n, test, samples, num_procs, scaling,  avg_time, 1);
+                openFile(FILENAMEMPIALL, code, mode, n, c, test, samples, num_procs, scaling,  avg_time, 1);
             }
             else {
-                openFile(FILENAMESEQ, code, mode, n, test, samples, num_procs,  scaling, avg_time, 1);
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs,  scaling, avg_time, 1);
             }
             break;
         case MPI_BLOCK:
             if (num_procs!=1) {
-                openFile(FILENAMEMPIBLOCK, code, mode, n, test, samples, num_procs, scaling, avg_time, 1);
+                openFile(FILENAMEMPIBLOCK, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
             }
             else {
-                openFile(FILENAMESEQ, code, mode, n, test, samples, num_procs,scaling,  avg_time, 1);
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs,scaling,  avg_time, 1);
             }
             break;
         case MPI_BLOCK_OPT:
             if (num_procs!=1) {
-                openFile(FILENAMEMPIBLOCKOPT, code, mode, n, test, samples, num_procs, scaling, avg_time, 1);
+                openFile(FILENAMEMPIBLOCKOPT, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_BATCH:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPIBATCH, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_HIER:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPIHIER, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_EXCHANGE:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPIEXCHANGE, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_AUTO:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPIAUTO, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_DISTRIBUTED:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPIDIST, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_SPARSE:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPISPARSE, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            else {
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
+            }
+            break;
+        case MPI_STREAM:
+            if (num_procs!=1) {
+                openFile(FILENAMEMPISTREAM, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
             }
             else {
-                openFile(FILENAMESEQ, code, mode, n, test, samples, num_procs, scaling, avg_time, 1);
+                openFile(FILENAMESEQ, code, mode, n, c, test, samples, num_procs, scaling, avg_time, 1);
             }
             break;
         default:
@@ -1006,44 +5585,98 @@ void openFilesAvgPerMode(const char* code, const int mode, int n, const int test
  *  Input:
  *      code (const char*) - A string representing the code identifier
  *      mode (const int) - The execution mode that determines which file will be opened and written to
- *      n (const int) - The dimension of the matrix (number of rows/columns)
+ *      n (const int) - The dimension of the matrix (number of rows)
+ *      c (int) - The number of columns of the matrix
  *      test (const int) - The test type used for matrix generation.
  *      samples (const int) - The number of samples for benchmarking.
  *      num_procs (const int) - The number of threads used in parallelism
  *      scaling (int) - Scaling mode defining 0. Strong 1. Weak
  *      time (const double) - The execution time taken for the operation
  */
-void openFilesResultsPerMode(const char* code, const int mode, int n, const int test, const int samples, const int num_procs, const int scaling, const double time) {
-    if(scaling==1) {
-        n=n/num_procs;
-    }
-    openFile(FILENAMETGEN, code, mode, n, test, samples, num_procs, scaling, time, 0);
+void openFilesResultsPerMode(const char* code, const int mode, int n, int c, const int test, const int samples, const int num_procs, const int scaling, const double time) {
+    openFile(FILENAMETGEN, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
     switch (mode) {
         case SEQ:
-            openFile(FILENAMETSEQ, code, mode, n, test, samples, num_procs, scaling, time, 0);
+            openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             break;
         case MPI_ALL:
             if (num_procs!=1) {
-                openFile(FILENAMETMPIALL, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETMPIALL, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             else {
-                openFile(FILENAMETSEQ, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             break;
         case MPI_BLOCK:
             if (num_procs!=1) {
-                openFile(FILENAMETMPIBLOCK, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETMPIBLOCK, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             else {
-                openFile(FILENAMETSEQ, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             break;
         case MPI_BLOCK_OPT:
             if (num_procs!=1) {
-                openFile(FILENAMETMPIBLOCKOPT, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETMPIBLOCKOPT, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_BATCH:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPIBATCH, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_HIER:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPIHIER, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_EXCHANGE:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPIEXCHANGE, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_AUTO:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPIAUTO, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_DISTRIBUTED:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPIDIST, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             else {
-                openFile(FILENAMETSEQ, code, mode, n, test, samples, num_procs, scaling, time, 0);
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_SPARSE:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPISPARSE, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            break;
+        case MPI_STREAM:
+            if (num_procs!=1) {
+                openFile(FILENAMETMPISTREAM, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
+            }
+            else {
+                openFile(FILENAMETSEQ, code, mode, n, c, test, samples, num_procs, scaling, time, 0);
             }
             break;
         default:
@@ -1052,24 +5685,382 @@ void openFilesResultsPerMode(const char* code, const int mode, int n, const int
     }
 }
 /*
- * Name: bubbleSort
- * Description: Sorts an array of doubles in ascending order using the bubble sort algorithm.
+ * Name: compareDoubles
+ * Compares two doubles for qsort in ascending order.
+ * Input:
+ *      a (const void*) - Pointer to the first double
+ *      b (const void*) - Pointer to the second double
+ * Output: int - Negative, zero or positive if the first is lower, equal or higher than the second
+ */
+int compareDoubles(const void* a, const void* b) {
+    const double x=*(const double*)a;
+    const double y=*(const double*)b;
+    return (x>y)-(x<y);
+}
+/*
+ * Name: compareInts
+ * Compares two integers for qsort in ascending order.
+ * Input:
+ *      a, b (const void*) - Pointers to the integers
+ * Output: int - Negative, zero or positive if a is less, equal or greater than b
+ */
+int compareInts(const void* a, const void* b) {
+    const int x=*(const int*)a;
+    const int y=*(const int*)b;
+    return (x>y)-(x<y);
+}
+/*
+ * Name: compareLongLongs
+ * Compares two long long integers for qsort in ascending order.
+ * Input:
+ *      a, b (const void*) - Pointers to the integers
+ * Output: int - Negative, zero or positive if a is less, equal or greater than b
+ */
+int compareLongLongs(const void* a, const void* b) {
+    const long long x=*(const long long*)a;
+    const long long y=*(const long long*)b;
+    return (x>y)-(x<y);
+}
+/*
+ * Name: percentile
+ * Computes a percentile of an array already sorted, interpolating linearly between the two nearest samples.
+ * Input:
+ *      sorted (const double*) - The array sorted in ascending order
+ *      size (int) - The number of elements in the array
+ *      p (double) - The percentile between 0 and 1
+ * Output: double - The value of the percentile
+ */
+double percentile(const double* sorted, int size, double p) {
+    const double position=p*(size-1);
+    const int below=(int)position;
+    if(below>=size-1) {
+        return sorted[size-1];
+    }
+    return sorted[below]+(position-below)*(sorted[below+1]-sorted[below]);
+}
+/*
+ * Name: computeStatistics
+ * Sorts the times of the samples with qsort and computes mean, median, percentiles, median absolute deviation and
+ * the confidence interval of the median. The interval is distribution free, taken from the order statistics at
+ * the ranks n/2 -+ Z_CONFIDENCE*sqrt(n)/2, so it doesn't assume normal times. The outliers are the samples
+ * farther from the median than OUTLIER_MADS times the MAD scaled to a standard deviation (x1.4826).
  * Input:
- *      a (double*) - A pointer to the array of doubles to be sorted.
- *      size (int) - The number of elements in the array.
+ *      a (double*) - The times of the samples, sorted in place
+ *      size (int) - The number of samples
+ *      stats (Statistics*) - The statistics computed
  * Output: none
  */
-void bubbleSort(double* a, int size);
-
-void bubbleSort(double* a, int size) {
-    int i, j;
-    for (i=0; i<(size-1); i++) {
-        for (j=0; j<(size-1-i); j++) {
-            if(a[j]>a[j+1]) {
-                double temp=a[j+1];
-                a[j+1]=a[j];
-                a[j]=temp;
+void computeStatistics(double* a, int size, Statistics* stats) {
+    int i;
+    double* deviations=malloc(sizeof(double)*size);
+    if(deviations==NULL) {
+        printf("Memory allocation failed\n");
+        MPI_Finalize();
+        exit(1);
+    }
+    qsort(a, size, sizeof(double), compareDoubles);
+    stats->samples=size;
+    stats->mean=0.0;
+    for (i=0; i<size; i++) {
+        stats->mean+=a[i];
+    }
+    stats->mean/=size;
+    stats->median=percentile(a, size, 0.5);
+    stats->p5=percentile(a, size, 0.05);
+    stats->p25=percentile(a, size, 0.25);
+    stats->p75=percentile(a, size, 0.75);
+    stats->p95=percentile(a, size, 0.95);
+    for (i=0; i<size; i++) {
+        deviations[i]=ABS_DIFF(a[i], stats->median);
+    }
+    qsort(deviations, size, sizeof(double), compareDoubles);
+    stats->mad=percentile(deviations, size, 0.5);
+    const double half=Z_CONFIDENCE*sqrt((double)size)/2;
+    const int low=MAX((int)floor(size/2.0-half), 0);
+    const int high=MIN((int)ceil(size/2.0+half), size-1);
+    stats->ci_low=a[low];
+    stats->ci_high=a[high];
+    stats->outliers=0;
+    for (i=0; i<size; i++) {
+        if(deviations[i]>OUTLIER_MADS*1.4826*stats->mad) {
+            stats->outliers++;
+        }
+    }
+    free(deviations);
+}
+/*
+ * Name: writeStatistics
+ * Appends the statistics of the samples of an execution to the file of the statistics, writing the header if the
+ * file is empty.
+ * Input:
+ *      code (const char*) - A string representing the code identifier
+ *      mode (const int) - The execution mode
+ *      n (const int) - The dimension of the matrix (number of rows)
+ *      c (const int) - The number of columns of the matrix
+ *      test (const int) - The test type used for matrix generation
+ *      num_procs (const int) - The number of processes
+ *      scaling (const int) - Scaling mode defining 0. Strong 1. Weak
+ *      stats (const Statistics*) - The statistics computed by computeStatistics
+ * Output: none
+ */
+void writeStatistics(const char* code, const int mode, const int n, const int c, const int test, const int num_procs, const int scaling, const Statistics* stats) {
+    const char* cache_names[3]={"cold", "warm", "clflush"};
+    FILE* file=fopen(FILENAMESTATS, "a+");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open or create %s\n", FILENAMESTATS);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file)==0) {
+        fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-15s %-15s %-15s %-15s %-15s %-15s %-10s %-10s\n", "Compile", "Mode", "Dimension", "Columns", "Test_Mode", "N Procs", "Scaling", "Samples", "Median(s)", "Mean(s)", "P5(s)", "P95(s)", "MAD(s)", "CI_Low(s)", "CI_High(s)", "IQR(s)", "Outliers", "Cache");
+    }
+    fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-15.12lf %-15.12lf %-15.12lf %-15.12lf %-15.12lf %-15.12lf %-10d %-10s\n", code, mode, n, c, test, num_procs, scaling, stats->samples, stats->median, stats->mean, stats->p5, stats->p95, stats->mad, stats->ci_low, stats->ci_high, stats->p75-stats->p25, stats->outliers, cache_names[options.cache]);
+    fclose(file);
+}
+/*
+ * Name: loadTimes
+ * Appends to set the times of the samples written in the file of the times of all the modes (FILENAMETGEN) of the
+ * results set in dir. The sets written before the scaling was introduced have no Scaling column and the number of
+ * processes (Threads) right before the time: their rows are read as strong scaling. The sets written before the
+ * Columns field have only square matrices, their columns are the dimension.
+ * Input:
+ *      dir (const char*) - Directory of the results set (for example All_Simulations/results_31)
+ *      set (TimeSet*) - The times read, grown as needed
+ * Output: bool - False if the file can't be opened
+ */
+bool loadTimes(const char* dir, TimeSet* set) {
+    char path[512];
+    char line[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, FILENAMETGEN);
+    FILE* file=fopen(path, "r");
+    if(file==NULL) {
+        fprintf(stderr, "Couldn't open %s\n", path);
+        return false;
+    }
+    flock(fileno(file), LOCK_SH);
+    if(fgets(line, sizeof(line), file)!=NULL) {
+        const bool scaled=(strstr(line, "Scaling")!=NULL);
+        const bool columns=(strstr(line, "Columns")!=NULL);
+        while(fgets(line, sizeof(line), file)!=NULL) {
+            TimeSample sample;
+            int findex, fsamples;
+            int fields;
+            if(columns) {
+                fields=sscanf(line, "%d %19s %d %d %d %d %d %d %d %lf", &findex, sample.code, &sample.mode, &sample.dim, &sample.cols, &sample.test, &fsamples, &sample.scaling, &sample.num_procs, &sample.time);
+            }
+            else if(scaled) {
+                fields=sscanf(line, "%d %19s %d %d %d %d %d %d %lf", &findex, sample.code, &sample.mode, &sample.dim, &sample.test, &fsamples, &sample.scaling, &sample.num_procs, &sample.time)+1;
+                sample.cols=sample.dim;
+            }
+            else {
+                sample.scaling=0;
+                fields=sscanf(line, "%d %19s %d %d %d %d %d %lf", &findex, sample.code, &sample.mode, &sample.dim, &sample.test, &fsamples, &sample.num_procs, &sample.time)+2;
+                sample.cols=sample.dim;
+            }
+            if(fields!=10) {
+                continue;
+            }
+            if(set->count==set->capacity) {
+                set->capacity=(set->capacity>0) ? set->capacity*2 : 1024;
+                TimeSample* grown=(TimeSample*)realloc(set->samples, sizeof(TimeSample)*set->capacity);
+                if(grown==NULL) {
+                    printf("Memory allocation failed\n");
+                    MPI_Finalize();
+                    exit(1);
+                }
+                set->samples=grown;
+            }
+            set->samples[set->count++]=sample;
+        }
+    }
+    flock(fileno(file), LOCK_UN);
+    fclose(file);
+    return true;
+}
+/*
+ * Name: compareConfigurations
+ * Compares the keys of the configurations of two times (code, mode, dimension, columns, test, processes, scaling).
+ * Input:
+ *      x, y (const TimeSample*) - The times
+ * Output: int - Negative, zero or positive if the configuration of x comes before, is the same or comes after the one of y
+ */
+int compareConfigurations(const TimeSample* x, const TimeSample* y) {
+    const int code=strcmp(x->code, y->code);
+    if(code!=0) {
+        return code;
+    }
+    if(x->mode!=y->mode) {
+        return (x->mode>y->mode)-(x->mode<y->mode);
+    }
+    if(x->dim!=y->dim) {
+        return (x->dim>y->dim)-(x->dim<y->dim);
+    }
+    if(x->cols!=y->cols) {
+        return (x->cols>y->cols)-(x->cols<y->cols);
+    }
+    if(x->test!=y->test) {
+        return (x->test>y->test)-(x->test<y->test);
+    }
+    if(x->num_procs!=y->num_procs) {
+        return (x->num_procs>y->num_procs)-(x->num_procs<y->num_procs);
+    }
+    return (x->scaling>y->scaling)-(x->scaling<y->scaling);
+}
+/*
+ * Name: compareTimeSamples
+ * Compares two times for qsort by their configuration (see compareConfigurations) and then by time, so the times
+ * of a configuration are contiguous and sorted.
+ * Input:
+ *      a, b (const void*) - Pointers to the TimeSample
+ * Output: int - Negative, zero or positive if a comes before, together or after b
+ */
+int compareTimeSamples(const void* a, const void* b) {
+    const TimeSample* x=(const TimeSample*)a;
+    const TimeSample* y=(const TimeSample*)b;
+    const int configuration=compareConfigurations(x, y);
+    if(configuration!=0) {
+        return configuration;
+    }
+    return (x->time>y->time)-(x->time<y->time);
+}
+/*
+ * Name: mannWhitney
+ * Two-sided Mann-Whitney U test between two sorted samples of times. It doesn't assume normal times (they are
+ * skewed to the right by the noise) but only compares the ranks in the merged samples: the tied times get the
+ * average of their ranks, and the p-value comes from the normal approximation of U with the correction of the
+ * variance for the ties and the one of continuity.
+ * Input:
+ *      a (const double*) - The first sample, sorted in ascending order
+ *      n (int) - The size of a
+ *      b (const double*) - The second sample, sorted in ascending order
+ *      m (int) - The size of b
+ * Output: double - The p-value of the hypothesis that the two samples come from the same distribution
+ */
+double mannWhitney(const double* a, int n, const double* b, int m) {
+    int i=0, j=0;
+    double rank=1.0, rank_a=0.0, ties=0.0;
+    while (i<n || j<m) {
+        const double value=(j>=m || (i<n && a[i]<=b[j])) ? a[i] : b[j];
+        int t_a=0, t_b=0;
+        while (i<n && a[i]==value) {
+            t_a++;
+            i++;
+        }
+        while (j<m && b[j]==value) {
+            t_b++;
+            j++;
+        }
+        const double t=t_a+t_b;
+        rank_a+=t_a*(rank+(t-1)/2);
+        ties+=t*t*t-t;
+        rank+=t;
+    }
+    const double total=n+m;
+    const double u=rank_a-n*(n+1)/2.0;
+    const double mean=n*(double)m/2;
+    const double variance=n*(double)m/12*((total+1)-ties/(total*(total-1)));
+    if(variance<=0.0) {
+        return 1.0;
+    }
+    const double z=MAX(fabs(u-mean)-0.5, 0.0)/sqrt(variance);
+    return erfc(z/sqrt(2.0));
+}
+/*
+ * Name: compareResults
+ * Compares the times of the results set in options.current with the ones of the baseline set in
+ * options.baseline. The times of each configuration (code, mode, dimension, columns, test, processes, scaling) are pooled
+ * among all the runs of a set and compared with mannWhitney, the configurations with less than
+ * MIN_COMPARE_SAMPLES times on a side or in only one set are skipped. A change is flagged when it's significant
+ * (p-value below options.alpha) and the median moves by more than options.tolerance: rank 0 prints a table, appends
+ * it in FILENAMECOMPARE and the status is returned by all the processes to be the exit status of the program.
+ * Input:
+ *      rank (int) - The rank of the current process in MPI_COMM_WORLD
+ * Output: int - COMPARE_SLOWDOWN if a configuration is slower, otherwise COMPARE_SPEEDUP if one is faster,
+ *      COMPARE_SAME if none changed, 1 if a set can't be read
+ */
+int compareResults(int rank) {
+    int status=COMPARE_SAME;
+    if(rank==0) {
+        TimeSet base={NULL, 0, 0};
+        TimeSet current={NULL, 0, 0};
+        if(options.baseline==NULL) {
+            fprintf(stderr, "The comparison needs the baseline results set (--baseline=DIR)\n");
+            status=1;
+        }
+        else if(!loadTimes(options.baseline, &base) || !loadTimes(options.current, &current)) {
+            status=1;
+        }
+        else {
+            int i=0, j=0, matched=0, slower=0, faster=0;
+            qsort(base.samples, base.count, sizeof(TimeSample), compareTimeSamples);
+            qsort(current.samples, current.count, sizeof(TimeSample), compareTimeSamples);
+            double* base_times=(double*)malloc(sizeof(double)*MAX(base.count, 1));
+            double* current_times=(double*)malloc(sizeof(double)*MAX(current.count, 1));
+            if(base_times==NULL || current_times==NULL) {
+                printf("Memory allocation failed\n");
+                MPI_Finalize();
+                exit(1);
+            }
+            FILE* file=fopen(FILENAMECOMPARE, "a+");
+            if(file==NULL) {
+                fprintf(stderr, "Couldn't open or create %s\n", FILENAMECOMPARE);
+                exit(1);
+            }
+            fseek(file, 0, SEEK_END);
+            if(ftell(file)==0) {
+                fprintf(file, "%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-10s %-12s %-10s %s\n", "Compile", "Mode", "Dimension", "Columns", "Test_Mode", "N Procs", "Scaling", "Base_N", "Curr_N", "Base_Med(s)", "Curr_Med(s)", "Change(%)", "P_Value", "Verdict", "Baseline");
+            }
+            printf("Comparison of %s with the baseline %s (alpha %.3lf, tolerance %.2lf%%)\n", options.current, options.baseline, options.alpha, options.tolerance*100);
+            printf("%-15s %-5s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-15s %-15s %-10s %-12s %-10s\n", "Compile", "Mode", "Dimension", "Columns", "Test_Mode", "N Procs", "Scaling", "Base_N", "Curr_N", "Base_Med(s)", "Curr_Med(s)", "Change(%)", "P_Value", "Verdict");
+            //Both sets are sorted by key, so the configurations are matched walking them together
+            while (i<base.count && j<current.count) {
+                const int order=compareConfigurations(&base.samples[i], &current.samples[j]);
+                //The configurations in only one of the sets are skipped
+                if(order<0) {
+                    i++;
+                    continue;
+                }
+                if(order>0) {
+                    j++;
+                    continue;
+                }
+                const TimeSample key=current.samples[j];
+                int n=0, m=0;
+                while (i<base.count && compareConfigurations(&base.samples[i], &key)==0) {
+                    base_times[n++]=base.samples[i++].time;
+                }
+                while (j<current.count && compareConfigurations(&current.samples[j], &key)==0) {
+                    current_times[m++]=current.samples[j++].time;
+                }
+                if(n<MIN_COMPARE_SAMPLES || m<MIN_COMPARE_SAMPLES) {
+                    continue;
+                }
+                matched++;
+                const double base_median=percentile(base_times, n, 0.5);
+                const double current_median=percentile(current_times, m, 0.5);
+                const double change=current_median/base_median-1;
+                const double p=mannWhitney(base_times, n, current_times, m);
+                const char* verdict="same";
+                if(p<options.alpha && change>options.tolerance) {
+                    verdict="SLOWER";
+                    slower++;
+                }
+                else if(p<options.alpha && change<-options.tolerance) {
+                    verdict="FASTER";
+                    faster++;
+                }
+                printf("%-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-10.2lf %-12.3e %-10s\n", key.code, key.mode, key.dim, key.cols, key.test, key.num_procs, key.scaling, n, m, base_median, current_median, change*100, p, verdict);
+                fprintf(file, "%-15s %-5d %-10d %-10d %-10d %-10d %-10d %-10d %-10d %-15.12lf %-15.12lf %-10.2lf %-12.3e %-10s %s\n", key.code, key.mode, key.dim, key.cols, key.test, key.num_procs, key.scaling, n, m, base_median, current_median, change*100, p, verdict, options.baseline);
             }
+            fclose(file);
+            printf("\n%d configurations compared: %d slower, %d faster, %d unchanged\n", matched, slower, faster, matched-slower-faster);
+            status=(slower>0) ? COMPARE_SLOWDOWN : (faster>0) ? COMPARE_SPEEDUP : COMPARE_SAME;
+            free(base_times);
+            free(current_times);
         }
+        free(base.samples);
+        free(current.samples);
     }
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return status;
 }
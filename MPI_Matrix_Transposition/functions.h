@@ -7,6 +7,10 @@
 
 #ifndef functions_h
 #define functions_h
+//sched_setaffinity and the CPU_* macros of the pinning
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -14,17 +18,39 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/file.h>
 #include <errno.h>
 #include <sys/time.h>
 #include <mpi.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <math.h> //-lm
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #define KB 1024
+#define CACHELINE 64
+//Sizes of the caches used when they can't be read from sysfs
 #define CACHESIZEL1D (32*KB)
 #define CACHESIZEL1I (32*KB)
 #define CACHESIZEL2 (1024*KB)
 #define CACHESIZEL3 (36*KB*KB)
+#define SYSFSCACHE "/sys/devices/system/cpu/cpu0/cache"
+#define SYSFSCPU "/sys/devices/system/cpu"
+#define SYSFSNODE "/sys/devices/system/node"
+//Maximum processors of a node known by the topology
+#define MAX_CPUS 1024
 #define FILENAMETGEN "timesGeneral.csv"
 #define FILENAMEGEN "resultsGeneral.csv"
 #define FILENAMETSEQ "timesSequential.csv"
@@ -35,6 +61,31 @@
 #define FILENAMEMPIBLOCK "resultsMPIBlock.csv"
 #define FILENAMETMPIBLOCKOPT "timesMPIBLOCKOpt.csv"
 #define FILENAMEMPIBLOCKOPT "resultsMPIBLOCKOpt.csv"
+#define FILENAMETMPIBATCH "timesMPIBatch.csv"
+#define FILENAMEMPIBATCH "resultsMPIBatch.csv"
+#define FILENAMETMPIHIER "timesMPIHierarchical.csv"
+#define FILENAMEMPIHIER "resultsMPIHierarchical.csv"
+#define FILENAMETMPIEXCHANGE "timesMPIExchange.csv"
+#define FILENAMEMPIEXCHANGE "resultsMPIExchange.csv"
+#define FILENAMETMPIDIST "timesMPIDistributed.csv"
+#define FILENAMEMPIDIST "resultsMPIDistributed.csv"
+#define FILENAMETMPISPARSE "timesMPISparse.csv"
+#define FILENAMEMPISPARSE "resultsMPISparse.csv"
+#define FILENAMETMPISTREAM "timesMPIStream.csv"
+#define FILENAMEMPISTREAM "resultsMPIStream.csv"
+#define FILENAMETMPIAUTO "timesMPIAuto.csv"
+#define FILENAMEMPIAUTO "resultsMPIAuto.csv"
+#define FILENAMECOMPRESSION "compressionGeneral.csv"
+#define FILENAMEOVERLAP "overlapGeneral.csv"
+#define FILENAMESTREAM "streamGeneral.csv"
+#define FILENAMETUNING "tuningDatabase.csv"
+#define FILENAMESTATS "statisticsGeneral.csv"
+#define FILENAMEPHASES "phasesGeneral.csv"
+#define FILENAMECOUNTERS "countersGeneral.csv"
+#define FILENAMEBASELINE "baselineGeneral.csv"
+#define FILENAMEBANDWIDTH "bandwidthGeneral.csv"
+#define FILENAMECOMPARE "compareGeneral.csv"
+#define FILENAMEPACKED "packedGeneral.csv"
 
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
@@ -46,6 +97,57 @@
 #define MIN_SIZE pow(2, 4)
 #define MAX_SIZE pow(2, 12)
 #define MIN_SAMPLES 25
+#define MAX_BATCH 1024
+#define MAX_TILE 256
+//Specialized kernels of the local transposition: tiles from 2^KERNEL_TILE_MIN_LOG to 2^KERNEL_TILE_MAX_LOG, and square
+//blocks from 2^KERNEL_SIDE_MIN_LOG to 2^KERNEL_SIDE_MAX_LOG with all their bounds known at compile time
+#define KERNEL_TILE_MIN_LOG 2
+#define KERNEL_TILE_MAX_LOG 6
+#define KERNEL_SIDE_MIN_LOG 4
+#define KERNEL_SIDE_MAX_LOG 12
+//Biggest tile chosen by defaultTile when --tile isn't given
+#define DEFAULT_TILE 32
+//Side of the tiles of the manual packing of the optimized block mode
+#define PACK_TILE 32
+//Maximum values of each list of the sweep (--sizes, --modes, --tests, --procs)
+#define MAX_SWEEP 64
+//Samples of each candidate configuration measured by the autotuner
+#define TUNING_SAMPLES 5
+//Type of the elements of the matrices, part of the key of the tuning database
+#define ELEMENT_TYPE "float"
+//Confidence of the intervals of the statistics of the samples (95%)
+#define Z_CONFIDENCE 1.96
+//Samples farther than OUTLIER_MADS scaled MADs from the median are reported as outliers
+#define OUTLIER_MADS 3.0
+//Samples needed on both sides to compare the times of a configuration with the baseline
+#define MIN_COMPARE_SAMPLES 5
+//Exit status of the comparison: no significant change, at least a slowdown, only speedups (1 is an error)
+#define COMPARE_SAME 0
+#define COMPARE_SLOWDOWN 2
+#define COMPARE_SPEEDUP 3
+//Initial rows of the results store and slots of the index of the sequential times (powers of 2, both grow)
+#define RESULTS_ROWS 256
+#define SEQUENTIAL_SLOTS 1024
+//Seed of the static and structured tests, the random one uses --seed (a new one at every run by default)
+#define STATIC_SEED 38
+//Mismatches of the near-symmetric test, in random positions of the second half of the rows
+#define NEAR_SYM_MISMATCHES 4
+//Diagonals on each side of the main one of the banded test (N/BAND_FRACTION) and side of the blocks of the blocked test
+#define BAND_FRACTION 16
+#define BLOCK_SIDE 32
+//Rows of the dense buffer from which the slab of a sparse or packed matrix is compressed, and resolution of --density (in parts of SPARSE_SCALE)
+#define SPARSE_CHUNK 64
+#define SPARSE_SCALE 1000000
+//Position of the row i in the packed lower triangle of a symmetric matrix (the row i has the i+1 elements (i, 0..i))
+#define PACKED_OFFSET(I) ((long long)(I)*((I)+1)/2)
+//Repetitions of the STREAM copy and of the ping-pong of the latency measured by the baseline
+#define STREAM_REPEATS 10
+#define PINGPONG_REPEATS 100
+//Matrices of the ring of the stream on rank 0 and matrices in flight in the pipeline (scatter, transpose and gather)
+#define STREAM_SLOTS 4
+#define STREAM_STAGES 3
+//Kernel transposing the contiguous x x y matrix M in the contiguous y x x matrix T
+typedef void (*TransposeKernel)(const float* restrict M, float* restrict T, int x, int y);
 //Struct for Setup a Custom 2D Type
 typedef struct Communicator2D {
     MPI_Datatype submatrix_type;
@@ -67,7 +169,226 @@ typedef struct Transposer {
     int rank_dest;
     int coords_start[2];
     int coords_dest[2];
+    int rank_src;
+    int coords_src[2];
 } Transposer;
+//Enum to classify the schedules of the all-to-all exchange of blocks
+typedef enum {ALLTOALL, PAIRWISE, BRUCK, EKLUNDH, OVERLAP, EXCHANGES} Exchange;
+//Enum to classify the state of the caches at the start of a sample (cold with the flush buffer or clflush, warm)
+typedef enum {CACHE_COLD, CACHE_WARM, CACHE_CLFLUSH} CacheState;
+//Enum to classify the policies of placement of the processes on the processors of the node
+typedef enum {AFFINITY_NONE, AFFINITY_COMPACT, AFFINITY_SCATTER, AFFINITY_PARTNER} Affinity;
+//Enum to classify how the optimized block mode transposes the exchanged block (packed by hand or by a derived datatype)
+typedef enum {PACK_MANUAL, PACK_DATATYPE} Packing;
+//Suffix of the code of the runs of MPI_BLOCK_OPT with --pack=datatype in the files of the results
+#define PACK_DATATYPE_TAG "-dt"
+//Struct with a list of values of the sweep, given as a,b,c or as a range a:b
+typedef struct SweepList {
+    int values[MAX_SWEEP];
+    int count;
+} SweepList;
+//Struct for the optional parameters given after the mandatory ones (--name=value)
+typedef struct Options {
+    int batch;
+    int rows;
+    int cols;
+    long long compress;//Minimum bytes of an exchanged message to compress it (-1 disabled)
+    int node_size;//Processes per emulated node in the hierarchical mode (0 real nodes)
+    Exchange exchange;//Schedule of the all-to-all exchange
+    int tile;//Side of the tiles of the local transposition (0 untiled, -1 chosen by the shape)
+    int warmup;//Samples executed and discarded before the measured ones
+    double precision;//Relative half width of the confidence interval of the median to stop sampling (0 fixed samples)
+    int max_samples;//Maximum samples when the sampling is adaptive
+    int phases;//Measure the time of each phase of the transposition (0 disabled)
+    int counters;//Read the hardware counters around the local kernels (0 disabled)
+    CacheState cache;//State of the caches at the start of each sample
+    SweepList sweep_sizes;//Exponents of the sizes of the sweep (empty the one of the launch)
+    SweepList sweep_modes;//Modes of the sweep
+    SweepList sweep_tests;//Tests of the sweep (empty the one of the launch)
+    SweepList sweep_procs;//Numbers of processes of the sweep (empty the powers of 2 up to the launch)
+    unsigned long long seed;//Seed of the random test, the same on every rank (0 chosen by rank 0 from the time)
+    double density;//Percentage of the elements kept as nonzeros by the sparse mode
+    int packed;//Store the symmetric test packed, only the lower triangle (0 disabled)
+    Affinity affinity;//Placement of the processes and of their threads (AFFINITY_NONE left to the launcher)
+    int progress;//Thread driving the non-blocking transfers of the overlapped exchange (0 disabled)
+    const char* stream;//File or pipe with the matrices of the streaming mode (NULL generated by the producer stand-in)
+    Packing pack;//Transposition of the exchanged block of the optimized block mode
+    const char* baseline;//Directory of the results set compared by the comparison mode
+    const char* current;//Directory of the results set compared with the baseline
+    double alpha;//Significance level of the test of the comparison
+    double tolerance;//Relative change of the median below which a significant difference isn't flagged
+} Options;
+//Struct collecting the statistics of the wire compression of the exchanged messages
+typedef struct CompressionStats {
+    long long messages;
+    long long raw_bytes;
+    long long wire_bytes;
+    double codec_time;
+    double exchange_time;
+} CompressionStats;
+//Struct with the requests of the overlapped exchange and the thread completing them (see startProgress)
+typedef struct Progress {
+    int running;//1 if the thread was started (MPI_THREAD_MULTIPLE provided)
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t lock;//Protects the fields below, shared by the main thread and the progress one
+    pthread_cond_t posted;//Signaled by the main thread when a request is added
+    pthread_cond_t completed;//Signaled by the progress thread when some requests complete
+    MPI_Request* requests;
+    int* indices;
+    int* state;//0 pending, 1 completed, 2 completed and already returned by progressWaitAny
+    int count;
+    int capacity;
+    int pending;
+    double last;//Time of the last completion
+} Progress;
+//Struct collecting the time of the overlapped exchanges spent by the communication and the part not hidden
+typedef struct OverlapStats {
+    long long exchanges;
+    double communication;//From the first request posted to the last one completed
+    double exposed;//Time the main thread waited for the requests
+} OverlapStats;
+//Struct with a time read from a file of the times, with the key of its configuration
+typedef struct TimeSample {
+    char code[20];
+    int mode;
+    int dim;
+    int cols;
+    int test;
+    int num_procs;
+    int scaling;
+    double time;
+} TimeSample;
+//Struct with all the times of a results set (see loadTimes)
+typedef struct TimeSet {
+    TimeSample* samples;
+    int count;
+    int capacity;
+} TimeSet;
+//Struct with the statistics of the times of the samples
+typedef struct Statistics {
+    int samples;
+    double mean;
+    double median;
+    double p5;
+    double p25;
+    double p75;
+    double p95;
+    double mad;//Median absolute deviation from the median
+    double ci_low;//Confidence interval of the median
+    double ci_high;
+    int outliers;
+} Statistics;
+//Enum to classify the phases of a transposition measured with --phases
+typedef enum {PHASE_BCAST, PHASE_SCATTER, PHASE_CHECK, PHASE_TRANSPOSE, PHASE_EXCHANGE, PHASE_GATHER, PHASES} Phase;
+//Struct with the time spent by the process in each phase, summed over the samples
+typedef struct PhaseTimes {
+    double start[PHASES];
+    double total[PHASES];
+} PhaseTimes;
+//Enum to classify the hardware events read by the counters
+typedef enum {EVENT_CYCLES, EVENT_INSTRUCTIONS, EVENT_LLC_MISSES, EVENT_L1D_MISSES, EVENT_DTLB_MISSES, EVENTS} Event;
+//Struct with the hardware counters of the process, summed per phase over the samples
+typedef struct Counters {
+    int fd[EVENTS];//File descriptor of each event (-1 not available)
+    long long start[EVENTS];
+    long long total[PHASES][EVENTS];
+} Counters;
+//Struct with the caches of the node and the buffer written by the process to evict them before each sample
+typedef struct Cache {
+    long long l1d;//Bytes of each level (detected from sysfs, CACHESIZE* otherwise)
+    long long l1i;
+    long long l2;
+    long long l3;
+    int detected;//1 if the sizes come from sysfs
+    int node_procs;//Processes sharing the last level cache of the node
+    float* buffer;//Persistent flush buffer, allocated once by setupCache
+    long long count;//Floats of the flush buffer
+    int sweeps;
+} Cache;
+//Struct with the topology of the node read from sysfs and the processors where the process is pinned
+typedef struct Topology {
+    int cpus;//Processors of the node given to the job (union of the affinity masks of its processes)
+    int cpu[MAX_CPUS];//Their ids, in the order of the policy
+    int socket[MAX_CPUS];//Socket of each processor, indexed by id
+    int numa[MAX_CPUS];//NUMA node of each processor
+    int llc[MAX_CPUS];//Lowest processor sharing the last level cache with each processor
+    int sockets;
+    int numa_nodes;
+    int llcs;
+    int node_rank;
+    int node_size;
+    int first;//The process is pinned to cpu[first..first+count-1]
+    int count;
+    int domain;//Node and socket of the process, equal for the processes sharing a socket (-1 not pinned)
+} Topology;
+//Struct with a row of a file of the times (type 0) or of the averages (type 1), buffered until flushResults
+typedef struct ResultRow {
+    const char* filename;
+    int type;
+    char code[20];
+    int mode;
+    int dim;
+    int cols;
+    int test;
+    int samples;
+    int num_procs;
+    int scaling;
+    double time;
+    double seq_time;
+    double speedup;
+    double efficiency;
+} ResultRow;
+//Slot of the index of the sequential times, keyed by (code, mode, dimension, columns, test, scaling)
+typedef struct SequentialEntry {
+    char code[20];
+    int mode;
+    int dim;
+    int cols;
+    int test;
+    int scaling;
+    double time;
+    bool used;
+} SequentialEntry;
+//Struct with the rows of the run, written once by flushResults, and the index of the sequential times
+typedef struct ResultsStore {
+    ResultRow* rows;
+    int count;
+    int capacity;
+    SequentialEntry* sequential;//Open addressing table, loaded from FILENAMESEQ at the first lookup
+    int sequential_count;
+    int sequential_slots;
+} ResultsStore;
+//Struct with a slab of rows of a sparse matrix in CSR (compressed sparse rows): the nonzeros of the row i are
+//col_idx and values from row_ptr[i] to row_ptr[i+1]-1, in increasing order of column
+typedef struct Sparse {
+    int rows;//Rows of the slab
+    int first;//Global index of the first row of the slab
+    int nnz;
+    int capacity;//Nonzeros allocated in col_idx and values
+    int* row_ptr;
+    int* col_idx;//Global columns
+    float* values;
+} Sparse;
+//Nonzero exchanged by the sparse transposition, with its position in the start matrix
+typedef struct Triplet {
+    int col;
+    int row;
+    float value;
+} Triplet;
+//Struct for the node-aware hierarchical transposition
+typedef struct Hierarchy {
+    MPI_Comm node_comm;//Processes sharing the memory of a node
+    MPI_Comm leader_comm;//First process of each node (MPI_COMM_NULL for the others)
+    MPI_Win input_win;//Shared slabs of the start matrix of the node
+    MPI_Win output_win;//Shared slabs of the transposed matrix of the node
+    float* input;
+    float* output;
+    int node_rank;
+    int node_size;
+    int nodes;
+    int* node_of;//Node of each rank of actual_comm
+} Hierarchy;
 //Global variables accessible from main and functions.c
 extern float* globalsendptr;
 extern float* localrecvptr;
@@ -75,10 +396,59 @@ extern float* globalrecvptr;
 extern float* localsendptr;
 extern MPI_Comm actual_comm;
 extern Transposer transposer;
+extern Options options;
+extern CompressionStats compression_stats;
+extern Progress progress;
+extern OverlapStats overlap_stats;
+extern Hierarchy hierarchy;
+extern PhaseTimes phase_times;
+extern Counters counters;
+extern Cache cache;
+extern ResultsStore results_store;
+extern Topology topology;
+//Timers of the phases and counters of the local kernels (checksym and transpose), a single branch when they are disabled
+#define KERNEL_PHASE(P) ((P)==PHASE_CHECK || (P)==PHASE_TRANSPOSE)
+#define PHASE_BEGIN(P) do { if(options.phases) { phase_times.start[P]=MPI_Wtime(); } if(options.counters && KERNEL_PHASE(P)) { readCounters(counters.start); } } while(0)
+#define PHASE_END(P) do { if(options.counters && KERNEL_PHASE(P)) { accumulateCounters(P); } if(options.phases) { phase_times.total[P]+=MPI_Wtime()-phase_times.start[P]; } } while(0)
 //Enum to classify the execution_modes and test_modes
-typedef enum {START, SEQ, MPI_ALL, MPI_BLOCK, MPI_BLOCK_OPT, END} Mode;
+typedef enum {START, SEQ, MPI_ALL, MPI_BLOCK, MPI_BLOCK_OPT, MPI_BATCH, MPI_HIER, MPI_EXCHANGE, MPI_AUTO, MPI_BASELINE, MPI_SWEEP, MPI_DISTRIBUTED, MPI_SPARSE, MPI_STREAM, MPI_COMPARE, END} Mode;
 //OMP_LOC_TB, OMP_GLB_TB, END} Mode;
-typedef enum {RANDOM, STATIC, SYM, WORST} Test;
+typedef enum {RANDOM, STATIC, SYM, WORST, NEAR_SYM, BANDED, BLOCKED, TESTS} Test;
+//Struct with the ring of the matrices of the stream on rank 0, filled by the producer thread (see produceStream)
+typedef struct Stream {
+    float** ring[STREAM_SLOTS];//The matrix k is in the slot k%STREAM_SLOTS
+    double* arrival;//Time when each matrix was written in the ring (streamClock)
+    int total;//Matrices to produce
+    int produced;//Matrices written in the ring
+    int consumed;//Matrices already scattered, whose slot can be written again
+    int ended;//The producer has no more matrices (total reached or end of the source)
+    FILE* source;//Raw floats of the matrices one after the other (NULL generated with the test)
+    Test test;
+    int N;
+    int C;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;//Signaled by the producer when a matrix is written or the stream ends
+    pthread_cond_t freed;//Signaled by rank 0 when a slot can be written again
+} Stream;
+//Struct with the decomposition of a configuration on a communicator, reused by all its samples
+typedef struct Plan {
+    Mode mode;
+    Exchange exchange;
+    int tile;
+    int N;//Rows of the global matrix (of all the processes in weak scaling)
+    int C;//Columns of the global matrix
+    int batch;
+    int rows;//Rows of the start matrix of the process
+    int cols;//Columns of the block of the process (C for the modes working on rows)
+    int n_x;
+    int n_y;
+    MPI_Comm parent;
+    MPI_Comm comm;//Duplicate of parent, or its Cartesian grid in the block modes
+    DataCommunicate sending;
+    DataCommunicate receiving;
+    MPI_Datatype column;//Column of the block of MPI_BLOCK_OPT with --pack=datatype (MPI_DATATYPE_NULL otherwise)
+    TransposeKernel kernel;//Specialized kernel of the local transposition (NULL for the generic loops)
+} Plan;
 //Functions
 void createData(DataCommunicate* data, int n_procs_x, int n_procs_y);
 void freeData(DataCommunicate* data);
@@ -86,39 +456,150 @@ void setupCommunicator(Communicator2D* comm, int size[2], int subsizes[2], int s
 void commitCommunicator(Communicator2D* comm);
 void freeCommunicator(Communicator2D* comm);
 void dataPopulate(DataCommunicate* comm, int count, int delay, int disp_row, int disp_col);
+void balancePartition(DataCommunicate* comm, int N, int unit);
+void setupBatchCommunicators(Communicator2D* scatter, Communicator2D* gather, int batch, int N, int C, int rows);
 //Number generation
 float random_float2 (int min, int max);
 //Input Management
 void inputParameters(int argc);
 int valueInputed(int argc, const char* argv, int value);
+void optionalParameters(int argc, char* argv[]);
+void parseList(const char* list, SweepList* out, int min, int max, const char* name);
 //Space Management - Allocation and Deallocation
 float** createFloatMatrix(int x, int y);
 void create2DFloatMatrix(float*** m, int x, int y);
-void initializeMatrix(float** M, Test test, int x, int y);
+unsigned long long mixBits(unsigned long long x);
+float counterFloat(unsigned long long seed, long long i, long long j);
+void nearSymMismatch(unsigned long long matrix_seed, int k, int N, long long* row, long long* col);
+void initializeMatrix(float** M, Test test, int first, int x, int N, int C);
 void freeMemory(float** M, int size);
 void free2DMemory(float*** M);
 //Execution
-bool executionProgram(float** MGEN, float** M, float** T, float** TGEN, float** tempM, Mode mode, int N, int rows, int rank, int scaling, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender_mpi_all);
+void createTransposed(float*** TGEN, int x, int y, int rank);
+bool executionProgram(float** MGEN, float** M, float** T, float*** TGEN, float** tempM, Mode mode, int N, int C, int rows, int cols, int rank, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender_mpi_all, Communicator2D gather_mpi_all, MPI_Datatype column, TransposeKernel kernel);
+//Plans and Autotuning
+bool createPlan(Plan* plan, MPI_Comm comm, Mode mode, Exchange exchange, int tile, int N, int C, int batch);
+double runSample(Plan* plan, Test test, int rank, bool report);
+void freePlan(Plan* plan);
+int countNodes(MPI_Comm comm);
+bool lookupTuning(int N, int C, int num_procs, int nodes, int config[3]);
+void storeTuning(int N, int C, int num_procs, int nodes, int config[3], double time);
+bool autotune(Plan* plan, MPI_Comm comm, int N, int C, int rank);
+void runBenchmark(const char* code, const Mode mode, int N, int C, const int test, const int samples, const int scaling, const int over, int rank);
+void runSweep(const char* code, int N, int test, const int samples, const int scaling, int rank);
+//Streaming
+double streamClock(void);
+void* produceStream(void* arg);
+void runStream(const char* code, int N, int C, const int test, const int samples, const int scaling, const int over, int rank);
 //Check Symmetry Algorithms
 bool checkSym (float** M, int size);
 //bool checkSymMPIAllGather (float** M, int N, int rank, int rows);
-bool checkSymMPI (float** M, int N, int rank, int rows, int scaling);
+bool checkSymMPI (float** M, int N, int C, int rank);
+bool checkSymMPIBatch (float** MGEN, int N, int C, int rank, int batch);
 //Transposition Algorithms
-void matTranspose (float** M, float** T, int x, int y);
-void matTransposeMPIAllGather (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int rows, int scaling, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender);
-void matTransposeMPIBlock (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int rows, DataCommunicate sending, DataCommunicate receiving);
-void matTransposeMPIBlockOPT (float** MGEN, float** M, float** T, float** TGEN, float** tempM, int rank, int N, int rows, DataCommunicate sending, DataCommunicate receiving);
+int defaultTile(int x, int y);
+void matTranspose (float** M, float** T, int x, int y, TransposeKernel kernel);
+TransposeKernel selectKernel(int x, int y, int tile);
+void describeKernel(int x, int y, int tile, char* text, size_t size);
+void packTransposed(const float* restrict M, float* restrict buf, int x, int y);
+void matTransposeMPIAllGather (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int C, int rows, DataCommunicate sending, DataCommunicate receiving, TransposeKernel kernel);
+void matTransposeMPIBlock (float** MGEN, float** M, float** T, float** TGEN, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, TransposeKernel kernel);
+void matTransposeMPIBlockOPT (float** MGEN, float** M, float** T, float** TGEN, float** tempM, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, MPI_Datatype column);
+void matTransposeMPIBatch (float** M, float** T, int C, int rows, int batch, DataCommunicate sending, Communicator2D scatter, Communicator2D gather, TransposeKernel kernel);
+void setupHierarchy(Hierarchy* h, int input_count, int output_count);
+void freeHierarchy(Hierarchy* h);
+void matTransposeMPIHierarchical (float** M, float** T, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender);
+void exchangeBlocks(float* sendbuf, float* recvbuf, int block, Exchange algorithm);
+void matTransposeMPIExchange (float** M, float** T, int rank, int N, int C, int rows, int cols, DataCommunicate sending, DataCommunicate receiving, Communicator2D sender);
+void matTransposeMPIDistributed (float** M, float** T, int rows, int cols);
+void transposeOverlapped(float** M, float** T, int rows, int cols);
+bool checkSymDistributed (float** M, float** T, int N, int C, int rows);
+//Sparse Matrices
+void createSparse(Sparse* S, int rows, int first, int capacity);
+void reserveSparse(Sparse* S, int capacity);
+void freeSparse(Sparse* S);
+int sliceStart(int n, int num_procs, int p);
+int sliceOwner(int index, int n, int num_procs);
+void initializeSparse(Sparse* S, Test test, int N, int C);
+void matTransposeMPISparse (const Sparse* A, Sparse* T, int C);
+bool checkSymSparse (const Sparse* A, const Sparse* T, int N, int C);
+bool executionSparse(Sparse* A, Sparse* T, int N, int C);
+double runSampleSparse(Plan* plan, Test test, int rank, bool report);
+void controlSparse(const Sparse* A, const Sparse* T);
+//Packed Symmetric Matrices
+bool usePacked(Mode mode, Test test, int N, int C);
+float* createPacked(int first, int rows);
+void initializePacked(float* P, Test test, int first, int rows, int N);
+float packedElement(const float* P, int first, int i, int j);
+const float* transposePacked(const float* P);
+double runSamplePacked(Plan* plan, Test test, int rank, bool report);
+void writePacked(const char* code, const int mode, const int n, const int test, const int num_procs, const int scaling, const Statistics* stats, long long bytes);
+//Wire Compression of the exchanged messages
+int compressFloats(const float* in, int count, unsigned char* out);
+void decompressFloats(const unsigned char* in, int bytes, float* out, int count);
+void exchangeFloats(float* sendbuf, int dest, float* recvbuf, int source, int count, int tag);
+void reportCompression(const char* code, const int mode, const int n, const int num_procs, int rank);
+//Progress Engine of the non-blocking transfers
+void startProgress(int provided, int rank);
+void* progressLoop(void* arg);
+int progressAdd(MPI_Request request);
+int progressWaitAny(int first, int count);
+double progressWaitAll(void);
+void stopProgress(void);
+void reportOverlap(const char* code, const int mode, const int n, const int num_procs, const int scaling, int rank);
+//Timing of the phases
+void reportPhases(const char* code, const int mode, const int n, const int num_procs, const int scaling, const int samples, int rank);
+//Bandwidth Baseline
+void measureBaseline(int N, int C, int rank);
+bool lookupBaseline(int num_procs, double* copy);
+void reportBandwidth(const char* code, const int mode, const int n, const int num_procs, const int scaling, const double bytes, const double time);
+//Hardware Counters
+void setupCounters(void);
+void readCounters(long long values[EVENTS]);
+void accumulateCounters(Phase phase);
+void reportCounters(const char* code, const int mode, const int n, const int num_procs, const int scaling, const int samples, int rank);
+void freeCounters(void);
 //Control Results
 void printMatrix(float** M, int x, int y);
-void control(float** M, float** T, int N);
+void control(float** M, float** T, int x, int y);
+void controlDistributed(float** M, float** T, int rows, int cols);
 void matrixCheckPerRank(float** M, int rank, int x, int y);
-void bubbleSort(double* a, int size);
+//Statistics of the samples
+int compareDoubles(const void* a, const void* b);
+int compareInts(const void* a, const void* b);
+int compareLongLongs(const void* a, const void* b);
+double percentile(const double* sorted, int size, double p);
+void computeStatistics(double* a, int size, Statistics* stats);
+void writeStatistics(const char* code, const int mode, const int n, const int c, const int test, const int num_procs, const int scaling, const Statistics* stats);
+//Comparison with a baseline results set
+bool loadTimes(const char* dir, TimeSet* set);
+int compareConfigurations(const TimeSample* x, const TimeSample* y);
+int compareTimeSamples(const void* a, const void* b);
+double mannWhitney(const double* a, int n, const double* b, int m);
+int compareResults(int rank);
+//Topology and Pinning
+int readCpuList(const char* path, int* list, int max);
+int readSysfsInt(const char* path, int fallback);
+void setupTopology(MPI_Comm comm);
+int compareCpus(const void* a, const void* b);
+void partnerOrder(const int dims[2], int* order);
+void pinProcess(int position, int leader);
+void reorderPartners(MPI_Comm comm, const int dims[2], MPI_Comm* reordered);
+const char* affinityName(Affinity affinity);
 //Cache Management
-void clearCache(long long int dimCache);
-void clearAllCache(void);
+void setupCache(MPI_Comm comm);
+void flushCache(const void* const buffers[], const long long sizes[], int n);
+void freeCache(void);
 //Files csv Management
-double getSequential(const int dim, const char* code, const int mode, const int test, const int scaling);
-void openFile(const char* filename, const char* code, const int mode, const int dim, const int test, const int samples, const int num_threads, const int scaling, double avg_time, int type);
-void openFilesAvgPerMode(const char* code, const int mode, int n, const int test, const int samples, const int num_threads, const int scaling, const double avg_time);
-void openFilesResultsPerMode(const char* code, const int mode, int n, const int test, const int samples, const int num_threads, const int scaling, const double time);
+double getSequential(const int dim, const int cols, const char* code, const int mode, const int test, const int scaling);
+unsigned long long hashSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling);
+SequentialEntry* findSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling);
+void indexSequential(const char* code, const int mode, const int dim, const int cols, const int test, const int scaling, const double time);
+void loadSequential(void);
+int countLines(FILE* file);
+void writeResultRow(FILE* file, const ResultRow* row, int index);
+void flushResults(void);
+void openFile(const char* filename, const char* code, const int mode, const int dim, const int cols, const int test, const int samples, const int num_threads, const int scaling, double avg_time, int type);
+void openFilesAvgPerMode(const char* code, const int mode, int n, int c, const int test, const int samples, const int num_threads, const int scaling, const double avg_time);
+void openFilesResultsPerMode(const char* code, const int mode, int n, int c, const int test, const int samples, const int num_threads, const int scaling, const double time);
 #endif /* functions_h */
@@ -0,0 +1,282 @@
+//
+//  profiling.c
+//  Matrix Transposition
+//
+//  Optional profiling library based on the PMPI interface: linking this file together with functions.c and
+//  transpose.c (mpicc -O2 functions.c transpose.c profiling.c -o transpose -lm) every MPI call used by the
+//  transposition is counted, with its bytes, the histogram of the sizes of the messages and the time spent,
+//  and a summary of all the ranks is dumped at MPI_Finalize. Without this file nothing is intercepted.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#define FILENAMEPROFILING "profilingGeneral.csv"
+//Bucket 0 are the empty messages, bucket k>0 the messages from 2^(k-1) to 2^k-1 bytes
+#define HISTOGRAM_BUCKETS 40
+
+//Enum to classify the intercepted MPI functions
+typedef enum {PROF_SEND, PROF_RECV, PROF_ISEND, PROF_IRECV, PROF_ISCATTER, PROF_IGATHER, PROF_SENDRECV, PROF_BCAST, PROF_SCATTERV, PROF_GATHERV, PROF_ALLGATHER, PROF_REDUCE, PROF_ALLREDUCE, PROF_ALLTOALL, PROF_ALLTOALLV, PROF_BARRIER, PROF_FUNCTIONS} ProfiledFunction;
+static const char* profiled_names[PROF_FUNCTIONS]={"MPI_Send", "MPI_Recv", "MPI_Isend", "MPI_Irecv", "MPI_Iscatter", "MPI_Igather", "MPI_Sendrecv", "MPI_Bcast", "MPI_Scatterv", "MPI_Gatherv", "MPI_Allgather", "MPI_Reduce", "MPI_Allreduce", "MPI_Alltoall", "MPI_Alltoallv", "MPI_Barrier"};
+//Struct with the statistics of an MPI function in the current rank
+typedef struct Profile {
+    long long calls;
+    long long bytes;
+    double time;
+    long long histogram[HISTOGRAM_BUCKETS];
+} Profile;
+static Profile profile[PROF_FUNCTIONS];
+
+/*
+ * Name: typeBytes
+ * Returns the bytes of count elements of an MPI datatype.
+ * Input:
+ *      count (long long) - The number of elements
+ *      datatype (MPI_Datatype) - The datatype of the elements
+ * Output: long long - The number of bytes
+ */
+static long long typeBytes(long long count, MPI_Datatype datatype) {
+    int size;
+    PMPI_Type_size(datatype, &size);
+    return count*size;
+}
+/*
+ * Name: sumCounts
+ * Returns the sum of the counts of the processes of a communicator (the counts of the v collectives).
+ * Input:
+ *      counts (const int*) - The counts, one per process
+ *      comm (MPI_Comm) - The communicator
+ * Output: long long - The sum of the counts
+ */
+static long long sumCounts(const int* counts, MPI_Comm comm) {
+    int size, i;
+    long long sum=0;
+    PMPI_Comm_size(comm, &size);
+    for (i=0; i<size; i++) {
+        sum+=counts[i];
+    }
+    return sum;
+}
+/*
+ * Name: record
+ * Adds a call to the statistics of an MPI function.
+ * Input:
+ *      function (ProfiledFunction) - The MPI function
+ *      bytes (long long) - The bytes that went through the current rank in the call (sent by the root and received
+ *                          by the others in the rooted collectives, sent in the other calls)
+ *      time (double) - The time spent in the call
+ * Output: none
+ */
+static void record(ProfiledFunction function, long long bytes, double time) {
+    int bucket=0;
+    while (bucket<HISTOGRAM_BUCKETS-1 && (bytes>>bucket)>0) {
+        bucket++;
+    }
+    profile[function].calls++;
+    profile[function].bytes+=bytes;
+    profile[function].time+=time;
+    profile[function].histogram[bucket]++;
+}
+
+int MPI_Send(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Send(buf, count, datatype, dest, tag, comm);
+    record(PROF_SEND, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status* status) {
+    MPI_Status local;
+    int received;
+    const double start=PMPI_Wtime();
+    int result=PMPI_Recv(buf, count, datatype, source, tag, comm, &local);
+    const double time=PMPI_Wtime()-start;
+    PMPI_Get_count(&local, datatype, &received);
+    record(PROF_RECV, typeBytes((received==MPI_UNDEFINED) ? count : received, datatype), time);
+    if(status!=MPI_STATUS_IGNORE) {
+        *status=local;
+    }
+    return result;
+}
+
+//The non-blocking calls count the time to post the request, the transfer is completed later
+int MPI_Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+    record(PROF_ISEND, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Request* request) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Irecv(buf, count, datatype, source, tag, comm, request);
+    record(PROF_IRECV, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Iscatter(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm, MPI_Request* request) {
+    int rank, size;
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    const double start=PMPI_Wtime();
+    int result=PMPI_Iscatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
+    const double time=PMPI_Wtime()-start;
+    record(PROF_ISCATTER, (rank==root) ? typeBytes((long long)sendcount*size, sendtype) : typeBytes(recvcount, recvtype), time);
+    return result;
+}
+
+int MPI_Igather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm, MPI_Request* request) {
+    int rank, size;
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    const double start=PMPI_Wtime();
+    int result=PMPI_Igather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
+    const double time=PMPI_Wtime()-start;
+    record(PROF_IGATHER, (rank==root) ? typeBytes((long long)recvcount*size, recvtype) : typeBytes(sendcount, sendtype), time);
+    return result;
+}
+
+int MPI_Sendrecv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, int dest, int sendtag, void* recvbuf, int recvcount, MPI_Datatype recvtype, int source, int recvtag, MPI_Comm comm, MPI_Status* status) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype, source, recvtag, comm, status);
+    record(PROF_SENDRECV, typeBytes(sendcount, sendtype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Bcast(buffer, count, datatype, root, comm);
+    record(PROF_BCAST, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Scatterv(const void* sendbuf, const int sendcounts[], const int displs[], MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int rank;
+    PMPI_Comm_rank(comm, &rank);
+    const double start=PMPI_Wtime();
+    int result=PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    const double time=PMPI_Wtime()-start;
+    record(PROF_SCATTERV, (rank==root) ? typeBytes(sumCounts(sendcounts, comm), sendtype) : typeBytes(recvcount, recvtype), time);
+    return result;
+}
+
+int MPI_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, const int recvcounts[], const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int rank;
+    PMPI_Comm_rank(comm, &rank);
+    const double start=PMPI_Wtime();
+    int result=PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    const double time=PMPI_Wtime()-start;
+    record(PROF_GATHERV, (rank==root) ? typeBytes(sumCounts(recvcounts, comm), recvtype) : typeBytes(sendcount, sendtype), time);
+    return result;
+}
+
+int MPI_Allgather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    record(PROF_ALLGATHER, typeBytes(sendcount, sendtype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    record(PROF_REDUCE, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Allreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    record(PROF_ALLREDUCE, typeBytes(count, datatype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Alltoall(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+    int size;
+    PMPI_Comm_size(comm, &size);
+    const double start=PMPI_Wtime();
+    int result=PMPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    record(PROF_ALLTOALL, typeBytes((long long)sendcount*size, sendtype), PMPI_Wtime()-start);
+    return result;
+}
+
+int MPI_Alltoallv(const void* sendbuf, const int sendcounts[], const int sdispls[], MPI_Datatype sendtype, void* recvbuf, const int recvcounts[], const int rdispls[], MPI_Datatype recvtype, MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+    const double time=PMPI_Wtime()-start;
+    record(PROF_ALLTOALLV, typeBytes(sumCounts(sendcounts, comm), sendtype), time);
+    return result;
+}
+
+int MPI_Barrier(MPI_Comm comm) {
+    const double start=PMPI_Wtime();
+    int result=PMPI_Barrier(comm);
+    record(PROF_BARRIER, 0, PMPI_Wtime()-start);
+    return result;
+}
+
+/*
+ * Name: MPI_Finalize
+ * Gathers the statistics of all the ranks on rank 0 of MPI_COMM_WORLD, which prints for each function used the
+ * total calls and bytes and the minimum, average and maximum time among the ranks, and appends on the file
+ * FILENAMEPROFILING a line per rank and function with calls, bytes, time and the histogram of the sizes of the
+ * messages (lower bound in bytes of each non-empty bucket:calls). Then finalizes MPI.
+ * Input: none
+ * Output: int - The result of PMPI_Finalize
+ */
+int MPI_Finalize(void) {
+    int rank, size, r, f, b;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &size);
+    Profile* all=NULL;
+    if(rank==0) {
+        all=malloc(sizeof(profile)*size);
+        if(all==NULL) {
+            printf("Memory allocation failed\n");
+        }
+    }
+    PMPI_Gather(profile, (int)sizeof(profile), MPI_BYTE, all, (int)sizeof(profile), MPI_BYTE, 0, MPI_COMM_WORLD);
+    if(rank==0 && all!=NULL) {
+        FILE* file=fopen(FILENAMEPROFILING, "a+");
+        if(file!=NULL) {
+            fseek(file, 0, SEEK_END);
+            if(ftell(file)==0) {
+                fprintf(file, "%-10s %-15s %-12s %-15s %-15s %s\n", "Rank", "Function", "Calls", "Bytes", "Time(s)", "Histogram(bytes:calls)");
+            }
+        }
+        else {
+            fprintf(stderr, "Couldn't open or create %s\n", FILENAMEPROFILING);
+        }
+        printf("\nMPI PROFILE OF %d RANKS:\n%-15s %-12s %-15s %-15s %-15s %-15s\n", size, "Function", "Calls", "Bytes", "Min Time(s)", "Avg Time(s)", "Max Time(s)");
+        for (f=0; f<PROF_FUNCTIONS; f++) {
+            long long calls=0, bytes=0;
+            double minimum=0.0, maximum=0.0, sum=0.0;
+            for (r=0; r<size; r++) {
+                const Profile* p=&all[r*PROF_FUNCTIONS+f];
+                calls+=p->calls;
+                bytes+=p->bytes;
+                sum+=p->time;
+                minimum=(r==0 || p->time<minimum) ? p->time : minimum;
+                maximum=(p->time>maximum) ? p->time : maximum;
+                if(file!=NULL && p->calls>0) {
+                    fprintf(file, "%-10d %-15s %-12lld %-15lld %-15.9lf ", r, profiled_names[f], p->calls, p->bytes, p->time);
+                    for (b=0; b<HISTOGRAM_BUCKETS; b++) {
+                        if(p->histogram[b]>0) {
+                            fprintf(file, "%lld:%lld ", (b==0) ? 0LL : 1LL<<(b-1), p->histogram[b]);
+                        }
+                    }
+                    fprintf(file, "\n");
+                }
+            }
+            if(calls>0) {
+                printf("%-15s %-12lld %-15lld %-15.9lf %-15.9lf %-15.9lf\n", profiled_names[f], calls, bytes, minimum, sum/size, maximum);
+            }
+        }
+        if(file!=NULL) {
+            fclose(file);
+        }
+        free(all);
+    }
+    return PMPI_Finalize();
+}
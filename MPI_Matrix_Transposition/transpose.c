@@ -21,40 +21,72 @@ float* globalrecvptr=NULL;
 float* localsendptr=NULL;
 MPI_Comm actual_comm;
 Transposer transposer;
+Options options;
+CompressionStats compression_stats;
+Progress progress;
+OverlapStats overlap_stats;
+Hierarchy hierarchy;
+PhaseTimes phase_times;
+Counters counters;
+Cache cache;
+ResultsStore results_store;
+Topology topology;
 
 int main(int argc, char * argv[]) {
     //Initialization
-    int i, j;
-    int count=0;
-    float** M=NULL;
-    float** MGEN=NULL;
-    float** T=NULL;
-    float** TGEN=NULL;
-    float** tempM=NULL;
-    double time=0.0;
-    //struct timeval start_tv, end_tv;
-    double tw_start=0.0, tw_end=0.0;
+    int i;
     //Input parameters
     inputParameters(argc);
+    optionalParameters(argc, argv);
     const char* CODE=argv[1];
     const Mode MODE=valueInputed(argc, argv[2], 2);
     int N=valueInputed(argc, argv[3], 3);
     const int TESTING=valueInputed(argc, argv[4], 4);
     const int SAMPLES=valueInputed(argc, argv[5], 5);
     const int SCALING=valueInputed(argc, argv[6], 6);//STRONG AND WEAK SCALING
-    double* results;
-    results=(double*)malloc(sizeof(double)*SAMPLES);
-    if (results==NULL) {
-        fprintf(stderr, "ERROR Memory Allocation");
-        MPI_Finalize();
-        exit(1);
+    //Rectangular matrices N x COLS (by default square)
+    const int COLS=(options.cols>0) ? options.cols : N;
+    if(options.rows>0) {
+        N=options.rows;
+    }
+    int rank, NUM_PROCS, provided=MPI_THREAD_SINGLE;
+    if(options.progress) {
+        //The progress thread calls MPI together with the main one
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    }
+    else {
+        MPI_Init(&argc, &argv);
     }
-    int rank, NUM_PROCS;
-    MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &NUM_PROCS);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    int n_x=1, n_y=1;
-    int rows=1;
+    //The elements are generated from their position, so all the ranks need the same seed
+    if(rank==0 && options.seed==0) {
+        options.seed=(unsigned long long)time(NULL);
+    }
+    MPI_Bcast(&options.seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    setupCounters();
+    //Pinned before the flush buffer is touched, so its pages are on the NUMA node of the process
+    setupTopology(MPI_COMM_WORLD);
+    setupCache(MPI_COMM_WORLD);
+    startProgress(provided, rank);
+    //The comparison only reads the times of two results sets, the exit status tells if something got slower
+    if(MODE==MPI_COMPARE) {
+        const int status=compareResults(rank);
+        freeCounters();
+        freeCache();
+        stopProgress();
+        MPI_Finalize();
+        return status;
+    }
+    //The sweep carves its own communicators of every number of processes from MPI_COMM_WORLD
+    if(MODE==MPI_SWEEP) {
+        runSweep(CODE, N, TESTING, SAMPLES, SCALING, rank);
+        freeCounters();
+        freeCache();
+        stopProgress();
+        MPI_Finalize();
+        return 0;
+    }
     int over=0;
     //Delete exceeding processes
     int ranges[1][3];
@@ -86,207 +118,25 @@ int main(int argc, char * argv[]) {
     }
     over=ranges[0][1]-ranges[0][0]+1;
     if(actual_comm==MPI_COMM_NULL) {
+        stopProgress();
         MPI_Finalize();
         exit(1);
     }
     NUM_PROCS=MIN(NUM_PROCS, N);
-    /*if(SCALING==1) {
-        N=N*NUM_PROCS;
-    }*/
-    //Initialize number of rows per process
-    if(MODE==MPI_BLOCK || MODE==MPI_BLOCK_OPT) {
-        n_x=(int)sqrt(NUM_PROCS);
-        n_y=(int)sqrt(NUM_PROCS);
-        rows=N/n_y;
-        if(N%(n_x*n_y)!=0) {
-            printf("Number of threads %d is not the square root of N=%d\n", NUM_PROCS, rank);
-            MPI_Finalize();
-            return 0;
-        }
-        int dims[2]={n_x, n_y};
-        int periods[2]={1, 1};
-        int reorder=1;
-        MPI_Cart_create(actual_comm, 2, dims, periods, reorder, &actual_comm);
-        MPI_Comm_rank(actual_comm, &transposer.rank_start);
-        MPI_Cart_coords(actual_comm, transposer.rank_start, 2, transposer.coords_start);
-        transposer.coords_dest[1]=transposer.coords_start[0];
-        transposer.coords_dest[0]=transposer.coords_start[1];
-        MPI_Cart_rank(actual_comm, transposer.coords_dest, &transposer.rank_dest);
-        printf("Rank %d -> Cartesian Rank Start %d, Coordinates (%d, %d) - Cartesian Rank End %d, Coordinates (%d, %d)\n", rank, transposer.rank_start, transposer.coords_start[0], transposer.coords_start[1], transposer.rank_dest, transposer.coords_dest[0], transposer.coords_dest[1]);
-        MPI_Barrier(actual_comm);
-    }
-    else {
-        if(MODE==SEQ && NUM_PROCS!=1) {
-            printf("This mode can be run only with 1 process", NUM_PROCS, rank);
-            MPI_Finalize();
-            return 1;
-        }
-        if (N % NUM_PROCS == 0) {
-            rows=N/NUM_PROCS;
-        } else {
-            rows=N/NUM_PROCS+(rank<N%NUM_PROCS ? 1 : 0);
-        }
-        n_x=1;
-        n_y=NUM_PROCS;
-        printf("Hello rank %d out of %d\n", rank+1, NUM_PROCS);
+    if(MODE==MPI_BASELINE) {
+        //Rows of the global matrix, in weak scaling each process has its own N x COLS
+        measureBaseline((SCALING==1) ? N*NUM_PROCS : N, COLS, rank);
     }
-    printf("%d/%d\t", rank, NUM_PROCS);
-    //Setup communicators
-    Communicator2D sender_mpi_all;
-    int size[2]={N, N};
-    int subsizes[2];
-    int starts[2]={0, 0};
-    Communicator2D gen_matrix;
-    subsizes[0]=N;
-    subsizes[1]=N;
-    setupCommunicator(&gen_matrix, size, subsizes, starts, subsizes[0]*subsizes[1]);
-    DataCommunicate sending, receiving;
-    //For create data x for columns y for rows
-    if(MODE==MPI_ALL || MODE==SEQ) {
-        createData(&sending, 1, NUM_PROCS);
-        createData(&receiving, 1, n_y);
+    else if(MODE==MPI_STREAM) {
+        runStream(CODE, N, COLS, TESTING, SAMPLES, SCALING, over, rank);
     }
     else {
-        if(MODE==MPI_BLOCK || MODE==MPI_BLOCK_OPT) {
-            createData(&sending, n_x, n_y);
-            createData(&receiving, n_x, n_y);
-        }
-    }
-    if(rank==0) {
-        if(MODE==MPI_ALL || MODE==SEQ) {
-            dataPopulate(&sending, 1, 0, 1, 0);
-        }
-    }
-    //Sampling Phase
-    while (count<SAMPLES) {
-        //Allocation in memory
-        clearAllCache();
-        //Setuping Allocation in memory
-        if(SCALING==0) {
-            create2DFloatMatrix(&MGEN, N, N);
-            if(rank==0) {
-                create2DFloatMatrix(&TGEN, N, N);
-                initializeMatrix(MGEN, TESTING, N, N);
-                //printMatrix(MGEN, N, N);
-                globalrecvptr=&(TGEN[0][0]);
-            }
-        }
-        else {
-            if(SCALING==1) {
-                rows=N;
-                create2DFloatMatrix(&MGEN, N*NUM_PROCS, N);
-                if(rank==0) {
-                    create2DFloatMatrix(&TGEN, N, N*NUM_PROCS);
-                    initializeMatrix(MGEN, TESTING, N*NUM_PROCS, N);
-                    //printMatrix(MGEN, N*NUM_PROCS, N);
-                    globalrecvptr=&(TGEN[0][0]);
-                }
-            }
-        }
-        globalsendptr=&(MGEN[0][0]);
-        subsizes[0]=N;
-        subsizes[1]=N;
-        //Broadcasting the main matrix to all processes
-        setupCommunicator(&gen_matrix, size, subsizes, starts, subsizes[0]*subsizes[1]);
-        commitCommunicator(&gen_matrix);
-        MPI_Bcast(globalsendptr, 1, gen_matrix.resized_type, 0, actual_comm);
-        //printf("===== RANK %d =====\n", rank);
-        //printMatrix(MGEN, N, N);
-        freeCommunicator(&gen_matrix);
-        //Allocate submatrices
-        if(MODE==MPI_ALL || MODE==SEQ) {
-            create2DFloatMatrix(&M, rows, N);
-            create2DFloatMatrix(&T, N, rows);
-            size[0]=N;
-            size[1]=N;
-            subsizes[0]=rows;
-            subsizes[1]=N;
-            starts[0]=0;
-            starts[1]=0;
-            setupCommunicator(&sender_mpi_all, size, subsizes, starts, subsizes[0]*subsizes[1]);
-            commitCommunicator(&sender_mpi_all);
-        }
-        else {
-            if(MODE==MPI_BLOCK || MODE==MPI_BLOCK_OPT) {
-                create2DFloatMatrix(&M, rows, rows);
-                create2DFloatMatrix(&T, rows, rows);
-                //commitCommunicator(&sender_mpi_block);
-            }
-            if(MODE==MPI_BLOCK_OPT) {
-                create2DFloatMatrix(&tempM, rows, rows);
-            }
-        }
-        localrecvptr=&(M[0][0]);
-        //Starting Transposition
-        if(rank==0) {
-            tw_start=MPI_Wtime();
-        }
-        bool symmetry=executionProgram(MGEN, M, T, TGEN, tempM, MODE, N, rows, rank, SCALING, sending, receiving, sender_mpi_all);
-        //Ending Transposition
-        //MPI_Barrier(actual_comm);
-        if(rank==0) {
-            tw_end=MPI_Wtime();
-            time=(tw_end-tw_start);
-            if (symmetry) {
-                printf("The matrix is symmetric.\n");
-            } else {
-                printf("The matrix is NOT symmetric.\n");
-            }
-            printf("Time Elapsed (get time)=%.12f\n", time);
-            if(!symmetry) {
-                /*if(SCALING==1) {
-                    printMatrix(TGEN, N, N*NUM_PROCS);
-                }*/
-                control(MGEN, TGEN, N);
-            }
-            openFilesResultsPerMode(CODE, MODE, N, TESTING, SAMPLES, NUM_PROCS, SCALING, time);
-            results[count]=time;
-        }
-        //Freeing elements
-        free2DMemory(&MGEN);
-        free2DMemory(&M);
-        free2DMemory(&T);
-        if(rank==0) {
-            free2DMemory(&TGEN);
-        }
-        if(MODE==MPI_ALL || MODE==SEQ) {
-            freeCommunicator(&sender_mpi_all);
-        }
-        if(MODE==MPI_BLOCK_OPT) {
-            free2DMemory(&tempM);
-        }
-        count++;
-        MPI_Barrier(actual_comm);
-    }
-    //Exit sampling and compute average
-    freeData(&sending);
-    freeData(&receiving);
-    if(rank!=0) {
-        MPI_Finalize();
-        return 0;
-    }
-    NUM_PROCS+=over;
-    //Take the 10 values in the middle
-    const int TAKE_SAMPLES=SAMPLES/5*2;//40%
-    int start, end;
-    //if(NUM_PROCS!=64) {
-    start=SAMPLES/2-TAKE_SAMPLES/2;
-    end=SAMPLES/2+TAKE_SAMPLES/2;
-    /*}
-     else {
-     start=0;
-     end=TAKE_SAMPLES;
-     }*/
-    double total_time=0.0;
-    bubbleSort(results, SAMPLES);
-    for (i=start; i<end; i++) {
-        total_time+=results[i];
-        printf("%.12lf\n", results[i]);
+        runBenchmark(CODE, MODE, N, COLS, TESTING, SAMPLES, SCALING, over, rank);
     }
-    printf("\n\nFINAL RESULTS WITH:\nMODE %d\nDimension: %d\nTesting: %d\nSamples: %d\nThreads: %d\nAverage Time: %.12lf secs\n\n", MODE, N, TESTING, SAMPLES, NUM_PROCS, total_time/TAKE_SAMPLES);
-    openFilesAvgPerMode(CODE, MODE, N, TESTING, SAMPLES, NUM_PROCS, SCALING, total_time/TAKE_SAMPLES);
-    free(results);
+    freeCounters();
+    freeCache();
     MPI_Comm_free(&actual_comm);
+    stopProgress();
     MPI_Finalize();
     return 0;
 }